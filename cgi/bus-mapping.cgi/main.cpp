@@ -1,5 +1,5 @@
 /**
-  Caution : shared memory에 대한 쓰기 동작이 있어서, 읽기와 쓰기 권한이 있어야 함(chmod a+w /dev/shm/bus_approach)
+  /bus_approach 는 onvif_streamer 가 쓰는 binary 채널(bus_sequence.hpp)이며, 여기서는 읽기만 함
  */
 
 #if 1
@@ -20,11 +20,11 @@
 #include <string>
 #include <unordered_map>
 
+#include "bus_sequence.hpp"
+
 using json = nlohmann::json;
 
-#define MAX_BUSES 10
-#define MAX_PLATE_LENGTH 24
-#define SHM_SIZE 4096  // JSON 데이터를 위한 충분한 크기
+#define SHM_SIZE 4096  // onvif_streamer 와 같은 크기
 
 const char* SHM_SEQUENCE_NAME = "/bus_approach";
 const size_t SHM_SEQUENCE_SIZE = SHM_SIZE;
@@ -65,92 +65,95 @@ void update_route_map_from_file() {
   last_modified_time = file_stat.st_mtime;
 }
 
-json read_bus_sequence() {
-  json result = json::array();
+// 공유 메모리 매핑은 프로세스가 살아있는 동안 유지
+const BusSequence* bus_sequence = nullptr;
+
+// 이 프로세스가 마지막으로 읽은 위치 (epoch 가 바뀌면 writer 재시작)
+// 프로세스 시작 후 첫 snapshot 은 위치만 맞추고 이전 번호판은 돌려주지 않음
+bool has_cursor = false;
+uint64_t read_epoch = 0;
+uint32_t read_count = 0;
 
-  // 공유 메모리 열기 (없으면 생성) - 모든 사용자 접근 가능
-  int fd = shm_open(SHM_SEQUENCE_NAME, O_CREAT | O_RDWR, 0777);
+const BusSequence* map_bus_sequence() {
+  if (bus_sequence != nullptr) return bus_sequence;
+
+  // writer(onvif_streamer)가 아직 없으면 다음 요청에서 다시 시도
+  int fd = shm_open(SHM_SEQUENCE_NAME, O_RDONLY, 0);
   if (fd == -1) {
-    std::cerr << "[ERROR] shm_open failed: " << strerror(errno) << std::endl;
-    return result;
+    std::cerr << "[WARN] shm_open failed: " << strerror(errno) << std::endl;
+    return nullptr;
   }
 
-  // 공유 메모리 크기 설정 (새로 생성된 경우)
-  if (ftruncate(fd, SHM_SEQUENCE_SIZE) == -1) {
-    std::cerr << "[ERROR] ftruncate failed: " << strerror(errno) << std::endl;
+  struct stat shm_stat;
+  if (fstat(fd, &shm_stat) == -1 || static_cast<size_t>(shm_stat.st_size) < sizeof(BusSequence)) {
+    std::cerr << "[WARN] Shared memory not initialized yet" << std::endl;
     close(fd);
-    return result;
+    return nullptr;
   }
 
-  void* addr = mmap(nullptr, SHM_SEQUENCE_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  void* addr = mmap(nullptr, SHM_SEQUENCE_SIZE, PROT_READ, MAP_SHARED, fd, 0);
   close(fd);
 
   if (addr == MAP_FAILED) {
     std::cerr << "[ERROR] mmap failed: " << strerror(errno) << std::endl;
-    return result;
+    return nullptr;
   }
 
-  // 공유 메모리에서 JSON 문자열 읽기
-  char* shm_data = static_cast<char*>(addr);
-  
-  // null 종료 문자 찾기
-  std::string json_str(shm_data);
-  size_t null_pos = json_str.find('\0');
-  if (null_pos != std::string::npos) {
-    json_str = json_str.substr(0, null_pos);
-  }
-  
-  // 빈 문자열이면 빈 결과 반환
-  if (json_str.empty() || json_str.find_first_not_of(" \t\n\r") == std::string::npos) {
-    munmap(addr, SHM_SEQUENCE_SIZE);
+  bus_sequence = static_cast<const BusSequence*>(addr);
+  return bus_sequence;
+}
+
+json read_bus_sequence() {
+  json result = json::array();
+
+  const BusSequence* shm = map_bus_sequence();
+  if (shm == nullptr) return result;
+
+  // seqlock 으로 일관된 복사본만 사용 (쓰는 중이면 재시도)
+  BusSequenceSnapshot snapshot;
+  if (!bus_sequence_read(shm, snapshot)) {
+    std::cerr << "[WARN] No consistent bus sequence snapshot" << std::endl;
     return result;
   }
 
-  try {
-    // JSON 파싱
-    json shm_json = json::parse(json_str);
-    
-    // JSON 배열인지 확인
-    if (!shm_json.is_array()) {
-      std::cerr << "[ERROR] Shared memory data is not a JSON array" << std::endl;
-      munmap(addr, SHM_SEQUENCE_SIZE);
-      return result;
-    }
+  if (!has_cursor) {
+    has_cursor = true;
+    read_epoch = snapshot.epoch;
+    read_count = snapshot.count;
+    return result;
+  }
 
-    // 각 버스 번호판에 대해 routeID 매칭
-    for (const auto& item : shm_json) {
-      if (item.is_object() && item.contains("busNumber")) {
-        std::string plate = item["busNumber"];
-        
-        if (!plate.empty()) {
-          json result_item;
-          result_item["busNumber"] = plate;
-
-          auto it = route_map.find(plate);
-          std::string route_id = (it != route_map.end()) ? it->second : "";
-          result_item["routeID"] = route_id;
-
-          // routeID가 있는 경우만 결과에 포함
-          if (route_id.length() > 0) {
-            result.push_back(result_item);
-          }
-        }
-      }
-    }
+  if (snapshot.epoch != read_epoch || snapshot.count < read_count) {
+    read_epoch = snapshot.epoch;
+    read_count = 0;
+  }
 
-  } catch (const json::parse_error& e) {
-    std::cerr << "[ERROR] JSON parse error: " << e.what() << std::endl;
-    std::cerr << "[DEBUG] Raw data: " << json_str << std::endl;
-  } catch (const std::exception& e) {
-    std::cerr << "[ERROR] Exception while processing JSON: " << e.what() << std::endl;
+  // 마지막으로 읽은 이후의 번호판만 (ring 에서 밀려난 것은 건너뜀)
+  uint32_t first = read_count;
+  if (snapshot.count - first > MAX_BUSES) {
+    std::cerr << "[WARN] Missed " << (snapshot.count - first - MAX_BUSES) << " plates" << std::endl;
+    first = snapshot.count - MAX_BUSES;
   }
 
-  // 공유 메모리 초기화 (빈 JSON 배열로)
-  std::string empty_json = "[]";
-  std::memset(shm_data, 0, SHM_SEQUENCE_SIZE);
-  std::memcpy(shm_data, empty_json.c_str(), empty_json.length());
+  // 각 버스 번호판에 대해 routeID 매칭
+  for (uint32_t n = first; n < snapshot.count; ++n) {
+    const char* slot = snapshot.plates[n % MAX_BUSES];
+    std::string plate(slot, strnlen(slot, MAX_PLATE_LENGTH));
+    if (plate.empty()) continue;
+
+    auto it = route_map.find(plate);
+    std::string route_id = (it != route_map.end()) ? it->second : "";
+
+    // routeID가 있는 경우만 결과에 포함
+    if (route_id.length() > 0) {
+      json result_item;
+      result_item["busNumber"] = plate;
+      result_item["routeID"] = route_id;
+      result.push_back(result_item);
+    }
+  }
 
-  munmap(addr, SHM_SEQUENCE_SIZE);
+  read_count = snapshot.count;
   return result;
 }
 
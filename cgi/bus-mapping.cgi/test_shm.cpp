@@ -1,20 +1,18 @@
-// Just for test(making shm with JSON data)
+// Just for test(publishing plates to the /bus_approach binary channel)
+// onvif_streamer 가 실행 중이 아닐 때만 사용 (writer 는 하나여야 함)
 #include <fcntl.h>
 #include <sys/mman.h>
 #include <unistd.h>
 
+#include <chrono>
 #include <cstring>
 #include <iostream>
 #include <string>
 #include <vector>
 
-#if 1
-#include "json.hpp"
-#endif
+#include "bus_sequence.hpp"
 
-using json = nlohmann::json;
-
-#define SHM_SIZE 4096  // JSON 데이터를 위한 충분한 크기
+#define SHM_SIZE 4096  // onvif_streamer 와 같은 크기
 
 int main() {
   const char* shm_name = "/bus_approach";
@@ -42,10 +40,14 @@ int main() {
     return 1;
   }
 
-  // JSON 데이터 생성
-  json test_data = json::array();
-  
-  // 예시 번호판 데이터 (중복 포함)
+  // 처음 쓰는 경우에만 초기화 (이미 있으면 이어서 추가)
+  BusSequence* bus_sequence = static_cast<BusSequence*>(addr);
+  if (bus_sequence->magic != BUS_SEQUENCE_MAGIC) {
+    bus_sequence_init(bus_sequence, std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count());
+  }
+
+  // 예시 번호판 데이터
   std::vector<std::string> plates = {
     "74사5815", 
     "75사1212", 
@@ -53,22 +55,14 @@ int main() {
     "74사1234"
   };
 
-  // JSON 배열에 번호판 추가
   for (const auto& plate : plates) {
-    test_data.push_back({{"busNumber", plate}});
+    if (!bus_sequence_publish(bus_sequence, plate.c_str())) {
+      std::cerr << "Plate too long: " << plate << std::endl;
+    }
   }
 
-  // JSON을 문자열로 변환
-  std::string json_str = test_data.dump();
-  std::cout << "Writing JSON to shared memory: " << json_str << std::endl;
-
-  // 공유 메모리에 JSON 문자열 쓰기
-  char* shm_data = static_cast<char*>(addr);
-  std::memset(shm_data, 0, shm_size);  // 초기화
-  std::memcpy(shm_data, json_str.c_str(), json_str.length());
-
-  std::cout << "Shared memory written with " << plates.size() << " bus plates in JSON format."
-            << std::endl;
+  std::cout << "Published " << plates.size() << " bus plates (total "
+            << bus_sequence->count << ")." << std::endl;
 
   munmap(addr, shm_size);
   close(fd);
@@ -80,7 +74,7 @@ int main() {
 g++ -std=c++17 -Wall -o test_shm test_shm.cpp -lrt
 
 사용 방법:
-./test_shm    # JSON 형태의 테스트 데이터를 공유 메모리에 쓰기
+./test_shm    # 테스트 번호판을 공유 메모리 채널에 추가
 
 공유 메모리 확인:
 ls -la /dev/shm/ | grep bus
@@ -0,0 +1,97 @@
+#ifndef BUS_SEQUENCE_HPP
+#define BUS_SEQUENCE_HPP
+
+// Wire format of /bus_approach, included by onvif_streamer (writer) and
+// cgi/bus-mapping.cgi (reader).
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+
+#define MAX_BUSES 10
+#define MAX_PLATE_LENGTH 24
+#define BUS_SEQUENCE_MAGIC 0x31535542u  // "BUS1"
+
+// --- /bus_approach plate channel ---
+// Fixed binary layout in POSIX shared memory. onvif_streamer is the only
+// writer: every newly recognised plate is appended to a ring of MAX_BUSES
+// slots and `count` (total plates ever published) moves on by one. Readers
+// never write; each keeps the count it last saw and takes the plates after
+// it, so several readers can follow the channel independently.
+//
+// `sequence` is a seqlock: odd while the writer is inside an update. A
+// reader copies the whole block and keeps the copy only if `sequence` was
+// even and unchanged across the copy, so it never sees a torn plate.
+// `epoch` changes whenever the writer (re)initialises the block, telling
+// readers to start over from count 0.
+struct BusSequence {
+    uint32_t magic;
+    std::atomic<uint32_t> sequence;
+    uint64_t epoch;
+    uint32_t count;
+    uint32_t reserved;
+    char plates[MAX_BUSES][MAX_PLATE_LENGTH];   // plate n lives in n % MAX_BUSES
+};
+
+static_assert(std::atomic<uint32_t>::is_always_lock_free, "seqlock needs a lock-free counter");
+static_assert(sizeof(BusSequence) <= 4096, "BusSequence must fit the /bus_approach mapping");
+
+// Consistent copy of the channel taken by bus_sequence_read()
+struct BusSequenceSnapshot {
+    uint64_t epoch;
+    uint32_t count;
+    char plates[MAX_BUSES][MAX_PLATE_LENGTH];
+};
+
+// Writer: reset the block and start a new epoch
+inline void bus_sequence_init(BusSequence* shm, uint64_t epoch) {
+    uint32_t seq = shm->sequence.load(std::memory_order_relaxed) | 1u;
+    shm->sequence.store(seq, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    shm->magic = BUS_SEQUENCE_MAGIC;
+    shm->epoch = epoch;
+    shm->count = 0;
+    shm->reserved = 0;
+    std::memset(shm->plates, 0, sizeof(shm->plates));
+    shm->sequence.store(seq + 1, std::memory_order_release);
+}
+
+// Writer: append one plate. Returns false for an empty plate or one that
+// does not fit a slot (it is not truncated).
+inline bool bus_sequence_publish(BusSequence* shm, const char* plate) {
+    size_t length = std::strlen(plate);
+    if (length == 0 || length >= MAX_PLATE_LENGTH) {
+        return false;
+    }
+    uint32_t seq = shm->sequence.load(std::memory_order_relaxed);
+    shm->sequence.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    char* slot = shm->plates[shm->count % MAX_BUSES];
+    std::memset(slot, 0, MAX_PLATE_LENGTH);
+    std::memcpy(slot, plate, length);
+    shm->count = shm->count + 1;
+    shm->sequence.store(seq + 2, std::memory_order_release);
+    return true;
+}
+
+// Reader: copy the block once no write is in progress. Returns false if the
+// block was never initialised or the writer kept it busy for `max_attempts`.
+inline bool bus_sequence_read(const BusSequence* shm, BusSequenceSnapshot& out, int max_attempts = 1000) {
+    for (int attempt = 0; attempt < max_attempts; ++attempt) {
+        uint32_t before = shm->sequence.load(std::memory_order_acquire);
+        if (before & 1u) {
+            continue;
+        }
+        uint32_t magic = shm->magic;
+        out.epoch = shm->epoch;
+        out.count = shm->count;
+        std::memcpy(out.plates, shm->plates, sizeof(out.plates));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (shm->sequence.load(std::memory_order_relaxed) == before) {
+            return magic == BUS_SEQUENCE_MAGIC;
+        }
+    }
+    return false;
+}
+
+#endif // BUS_SEQUENCE_HPP
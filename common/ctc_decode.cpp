@@ -0,0 +1,88 @@
+#include "ctc_decode.hpp"
+
+#include <cmath>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define CTC_DECODE_NEON 1
+#elif defined(__SSE__)
+#include <xmmintrin.h>
+#define CTC_DECODE_SSE 1
+#endif
+
+namespace {
+
+float row_max(const float* row, int classes) {
+    int c = 0;
+    float best = row[0];
+#if defined(CTC_DECODE_NEON)
+    if (classes >= 4) {
+        float32x4_t m = vld1q_f32(row);
+        for (c = 4; c + 4 <= classes; c += 4) {
+            m = vmaxq_f32(m, vld1q_f32(row + c));
+        }
+        float32x2_t pair = vpmax_f32(vget_low_f32(m), vget_high_f32(m));
+        best = vget_lane_f32(vpmax_f32(pair, pair), 0);
+    }
+#elif defined(CTC_DECODE_SSE)
+    if (classes >= 4) {
+        __m128 m = _mm_loadu_ps(row);
+        for (c = 4; c + 4 <= classes; c += 4) {
+            m = _mm_max_ps(m, _mm_loadu_ps(row + c));
+        }
+        m = _mm_max_ps(m, _mm_movehl_ps(m, m));
+        m = _mm_max_ss(m, _mm_shuffle_ps(m, m, 1));
+        best = _mm_cvtss_f32(m);
+    }
+#endif
+    for (; c < classes; ++c) {
+        if (row[c] > best) {
+            best = row[c];
+        }
+    }
+    return best;
+}
+
+} // namespace
+
+void ctc_greedy_decode(const float* logits, int time, int classes, CtcDecodeResult& result, int blank) {
+    result.indices.clear();
+    result.step_probs.resize(time > 0 ? time : 0);
+    result.min_confidence = 0.0f;
+    result.mean_confidence = 0.0f;
+    if (time <= 0 || classes <= 0) {
+        return;
+    }
+
+    int prev = -1;
+    int counted = 0;
+    float min_confidence = 0.0f;
+    float sum_confidence = 0.0f;
+    for (int t = 0; t < time; ++t) {
+        const float* row = logits + static_cast<size_t>(t) * classes;
+        float max_val = row_max(row, classes);
+        int max_index = 0;
+        while (max_index < classes - 1 && row[max_index] != max_val) {
+            ++max_index;
+        }
+
+        // Logits are log probabilities
+        float prob = std::exp(max_val);
+        result.step_probs[t] = prob;
+
+        if (max_index != blank) {
+            if (max_index != prev) {
+                result.indices.push_back(max_index);
+            }
+            min_confidence = counted == 0 || prob < min_confidence ? prob : min_confidence;
+            sum_confidence += prob;
+            ++counted;
+        }
+        prev = max_index;
+    }
+
+    if (counted > 0) {
+        result.min_confidence = min_confidence;
+        result.mean_confidence = sum_confidence / counted;
+    }
+}
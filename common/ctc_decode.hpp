@@ -0,0 +1,23 @@
+#ifndef CTC_DECODE_HPP
+#define CTC_DECODE_HPP
+
+#include <vector>
+
+// Output of ctc_greedy_decode; keep one around so its vectors are reused
+struct CtcDecodeResult {
+    std::vector<int> indices;       // collapsed label indices, blanks removed
+    std::vector<float> step_probs;  // exp(max logit) per time step
+    float min_confidence = 0.0f;    // over non-blank steps, 0 if there are none
+    float mean_confidence = 0.0f;
+};
+
+// --- Fused greedy CTC decode ---
+// One pass over the [time x classes] log-probabilities: per step the
+// argmax (first maximum wins) is found with a vectorized max (NEON/SSE)
+// followed by a scan for its position, then repeats are collapsed, blanks
+// dropped, and the step probability folded into the min/mean confidence.
+// Equivalent to a greedy decoder plus a separate confidence pass, without
+// the second scan or per-call allocations.
+void ctc_greedy_decode(const float* logits, int time, int classes, CtcDecodeResult& result, int blank = 0);
+
+#endif // CTC_DECODE_HPP
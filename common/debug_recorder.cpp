@@ -0,0 +1,273 @@
+#include "debug_recorder.hpp"
+
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#include <pthread.h>
+#include <sched.h>
+#include <sys/stat.h>
+
+#include <opencv2/imgcodecs.hpp>
+
+#include "json.hpp"
+
+bool load_debug_recorder_config(const std::string& path, DebugRecorderConfig& config) {
+    std::ifstream file(path);
+    if (!file) {
+        return false;
+    }
+
+    DebugRecorderConfig loaded = config;
+    try {
+        nlohmann::json j = nlohmann::json::parse(file);
+        loaded.enabled = j.value("enabled", loaded.enabled);
+        loaded.directory = j.value("directory", loaded.directory);
+        if (j.contains("budget_mb")) {
+            loaded.budget_bytes = static_cast<uint64_t>(j["budget_mb"].get<double>() * (1 << 20));
+        }
+        loaded.queue_capacity = j.value("queue", loaded.queue_capacity);
+
+        if (j.contains("tags")) {
+            loaded.tags.clear();
+            for (const auto& item : j["tags"].items()) {
+                DebugTagConfig tag;
+                tag.enabled = item.value().value("enabled", tag.enabled);
+                tag.every = std::max<uint32_t>(1, item.value().value("every", tag.every));
+                loaded.tags[item.key()] = tag;
+            }
+        }
+    } catch (const nlohmann::json::exception& e) {
+        std::cerr << "[DEBUG] Failed to parse " << path << ": " << e.what() << std::endl;
+        return false;
+    }
+
+    config = loaded;
+    return true;
+}
+
+std::string describe_debug_recorder_config(const DebugRecorderConfig& config) {
+    if (!config.enabled) {
+        return "off";
+    }
+    std::ostringstream out;
+    out << "dir=" << config.directory
+        << " budget=" << (config.budget_bytes >> 20) << "MB"
+        << " queue=" << config.queue_capacity
+        << " tags=";
+    bool first = true;
+    for (const auto& tag : config.tags) {
+        if (!tag.second.enabled) {
+            continue;
+        }
+        out << (first ? "" : ",") << tag.first << "/" << tag.second.every;
+        first = false;
+    }
+    if (first) {
+        out << "none";
+    }
+    return out.str();
+}
+
+DebugRecorder::DebugRecorder() = default;
+
+DebugRecorder::~DebugRecorder() {
+    stop();
+}
+
+void DebugRecorder::start(const DebugRecorderConfig& config) {
+    stop();
+    config_ = config;
+
+    {
+        std::lock_guard<std::mutex> lock(tags_mutex_);
+        for (int i = 0; i < tag_count_.load(std::memory_order_relaxed); ++i) {
+            applyTagConfig(tags_[i]);
+        }
+    }
+
+    if (!config_.enabled || config_.tags.empty()) {
+        return;
+    }
+
+    mkdir(config_.directory.c_str(), 0777);
+    for (const auto& tag : config_.tags) {
+        if (tag.second.enabled) {
+            mkdir((config_.directory + "/" + tag.first).c_str(), 0777);
+        }
+    }
+
+    // Power of two so positions wrap with a mask
+    size_t capacity = 2;
+    while (capacity < config_.queue_capacity) {
+        capacity <<= 1;
+    }
+    cells_.reset(new Cell[capacity]);
+    for (size_t i = 0; i < capacity; ++i) {
+        cells_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    mask_ = capacity - 1;
+    enqueue_pos_.store(0, std::memory_order_relaxed);
+    dequeue_pos_ = 0;
+    over_budget_.store(false, std::memory_order_relaxed);
+
+    running_.store(true);
+    writer_ = std::thread(&DebugRecorder::writerLoop, this);
+    enabled_.store(true, std::memory_order_release);
+}
+
+void DebugRecorder::stop() {
+    enabled_.store(false);
+    if (!running_.exchange(false)) {
+        return;
+    }
+    if (writer_.joinable()) {
+        writer_.join();
+    }
+}
+
+DebugTag DebugRecorder::tag(const char* name) {
+    std::lock_guard<std::mutex> lock(tags_mutex_);
+    int count = tag_count_.load(std::memory_order_relaxed);
+    for (int i = 0; i < count; ++i) {
+        if (tags_[i].name == name) {
+            return i;
+        }
+    }
+    if (count == MAX_TAGS) {
+        std::cerr << "[DEBUG] Too many debug tags, \"" << name << "\" is never recorded" << std::endl;
+        return -1;
+    }
+    TagState& state = tags_[count];
+    state.name = name;
+    applyTagConfig(state);
+    tag_count_.store(count + 1, std::memory_order_release);
+    return count;
+}
+
+void DebugRecorder::applyTagConfig(TagState& state) {
+    auto it = config_.tags.find(state.name);
+    bool enabled = config_.enabled && it != config_.tags.end() && it->second.enabled;
+    state.every.store(enabled ? it->second.every : 1, std::memory_order_relaxed);
+    state.calls.store(0, std::memory_order_relaxed);
+    state.enabled.store(enabled, std::memory_order_relaxed);
+}
+
+bool DebugRecorder::sampleSlow(DebugTag tag) {
+    if (tag < 0 || tag >= tag_count_.load(std::memory_order_acquire)) {
+        return false;
+    }
+    TagState& state = tags_[tag];
+    if (!state.enabled.load(std::memory_order_relaxed)) {
+        return false;
+    }
+    uint32_t every = state.every.load(std::memory_order_relaxed);
+    return state.calls.fetch_add(1, std::memory_order_relaxed) % every == 0;
+}
+
+void DebugRecorder::record(DebugTag tag, const cv::Mat& image, const std::string& name) {
+    if (!enabled_.load(std::memory_order_acquire) || image.empty()) {
+        return;
+    }
+
+    // Claim a cell; a full ring drops the image instead of waiting
+    size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+    Cell* cell;
+    while (true) {
+        cell = &cells_[pos & mask_];
+        size_t sequence = cell->sequence.load(std::memory_order_acquire);
+        intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+        if (diff == 0) {
+            if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        } else {
+            pos = enqueue_pos_.load(std::memory_order_relaxed);
+        }
+    }
+
+    // The cell keeps its buffers, so same-sized images do not allocate
+    cell->tag = tag;
+    cell->name.assign(name);
+    image.copyTo(cell->image);
+    cell->sequence.store(pos + 1, std::memory_order_release);
+}
+
+void DebugRecorder::writerLoop() {
+#ifdef SCHED_IDLE
+    // Only run when nothing else wants the CPU
+    sched_param param{};
+    if (pthread_setschedparam(pthread_self(), SCHED_IDLE, &param) != 0) {
+        std::cerr << "[DEBUG] Could not lower the writer priority" << std::endl;
+    }
+#endif
+    std::cout << "[DEBUG] Recorder writing to " << config_.directory << "/ ("
+              << describe_debug_recorder_config(config_) << ")" << std::endl;
+
+    while (true) {
+        Cell& cell = cells_[dequeue_pos_ & mask_];
+        size_t sequence = cell.sequence.load(std::memory_order_acquire);
+        if (sequence == dequeue_pos_ + 1) {
+            writeOne(cell);
+            cell.sequence.store(dequeue_pos_ + mask_ + 1, std::memory_order_release);
+            dequeue_pos_++;
+            continue;
+        }
+        // Queue empty: poll rather than have producers signal
+        if (!running_.load()) {
+            break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+}
+
+bool DebugRecorder::writeOne(Cell& cell) {
+    if (over_budget_.load(std::memory_order_relaxed)) {
+        return false;
+    }
+
+    std::string path = config_.directory + "/" + tags_[cell.tag].name + "/" +
+                       std::to_string(file_counter_++) + "_" + cell.name;
+    bool written = false;
+    try {
+        written = cv::imwrite(path, cell.image);
+    } catch (const cv::Exception& e) {
+        std::cerr << "[DEBUG] imwrite " << path << " failed: " << e.what() << std::endl;
+    }
+    if (!written) {
+        failed_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    struct stat file_stat;
+    uint64_t size = stat(path.c_str(), &file_stat) == 0 ? static_cast<uint64_t>(file_stat.st_size) : 0;
+    uint64_t total = bytes_.fetch_add(size, std::memory_order_relaxed) + size;
+    recorded_.fetch_add(1, std::memory_order_relaxed);
+
+    if (total >= config_.budget_bytes) {
+        over_budget_.store(true, std::memory_order_relaxed);
+        enabled_.store(false, std::memory_order_relaxed);
+        std::cerr << "[DEBUG] Disk budget of " << (config_.budget_bytes >> 20)
+                  << "MB reached, recording stopped" << std::endl;
+    }
+    return true;
+}
+
+DebugRecorderStats DebugRecorder::stats() const {
+    DebugRecorderStats stats;
+    stats.recorded = recorded_.load(std::memory_order_relaxed);
+    stats.dropped = dropped_.load(std::memory_order_relaxed);
+    stats.failed = failed_.load(std::memory_order_relaxed);
+    stats.bytes = bytes_.load(std::memory_order_relaxed);
+    stats.over_budget = over_budget_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+DebugRecorder& debug_recorder() {
+    static DebugRecorder recorder;
+    return recorder;
+}
@@ -0,0 +1,148 @@
+#ifndef DEBUG_RECORDER_HPP
+#define DEBUG_RECORDER_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <opencv2/core.hpp>
+
+// Debug image output shared by onvif_streamer and yolo_lp_detector. Loaded
+// from a JSON file such as:
+//
+//   {
+//     "enabled": true,
+//     "directory": "debug",
+//     "budget_mb": 64,
+//     "queue": 16,
+//     "tags": {
+//       "ocr_input": {"every": 30},
+//       "plate_prep": {"every": 10},
+//       "result": {"every": 100, "enabled": false}
+//     }
+//   }
+//
+// Only listed tags are recorded; `every` keeps one call in N. Without the
+// file (or with "enabled": false) nothing is recorded.
+struct DebugTagConfig {
+    bool enabled = true;
+    uint32_t every = 1;
+};
+
+struct DebugRecorderConfig {
+    bool enabled = false;
+    std::string directory = "debug";
+    uint64_t budget_bytes = 64ull << 20;    // stop recording once this much was written
+    size_t queue_capacity = 16;             // images waiting for the writer
+    std::map<std::string, DebugTagConfig> tags;
+};
+
+// Returns false (and keeps `config` untouched) if the file cannot be read
+// or parsed
+bool load_debug_recorder_config(const std::string& path, DebugRecorderConfig& config);
+
+std::string describe_debug_recorder_config(const DebugRecorderConfig& config);
+
+struct DebugRecorderStats {
+    uint64_t recorded = 0;      // images written
+    uint64_t dropped = 0;       // sampled, but the queue was full
+    uint64_t failed = 0;        // imwrite errors
+    uint64_t bytes = 0;         // written so far, counted against the budget
+    bool over_budget = false;
+};
+
+using DebugTag = int;
+
+// --- Sampled debug image recorder ---
+// Hot paths ask sample(tag) first; with the recorder off that is a single
+// relaxed load and no image is touched. A sampled image is copied into a
+// preallocated slot of a bounded lock-free MPMC ring (any thread may record)
+// and a writer thread at idle priority encodes it to
+// <directory>/<tag>/<n>_<name>. A full ring drops the image rather than
+// waiting; once `budget_bytes` have been written recording switches off.
+class DebugRecorder {
+public:
+    DebugRecorder();
+    ~DebugRecorder();
+
+    // Applies the config and, if enabled, creates the directories and
+    // starts the writer. Call once at startup, before the hot paths run.
+    void start(const DebugRecorderConfig& config);
+    // Writes what is queued, then stops the writer
+    void stop();
+
+    // Handle for `name`; cheap enough for a function-local static
+    DebugTag tag(const char* name);
+
+    // True if this call of `tag` should be recorded
+    bool sample(DebugTag tag) {
+        if (!enabled_.load(std::memory_order_relaxed)) {
+            return false;
+        }
+        return sampleSlow(tag);
+    }
+
+    // Queue a copy of `image` (call only after sample() said yes); the file
+    // extension of `name` picks the format
+    void record(DebugTag tag, const cv::Mat& image, const std::string& name);
+
+    bool enabled() const { return enabled_.load(std::memory_order_relaxed); }
+    DebugRecorderStats stats() const;
+
+private:
+    static constexpr int MAX_TAGS = 16;
+
+    struct TagState {
+        std::string name;
+        std::atomic<bool> enabled{false};
+        std::atomic<uint32_t> every{1};
+        std::atomic<uint32_t> calls{0};
+    };
+
+    // Vyukov bounded queue cell; `sequence` hands the slot between
+    // producers and the writer
+    struct Cell {
+        std::atomic<size_t> sequence{0};
+        DebugTag tag = 0;
+        std::string name;
+        cv::Mat image;
+    };
+
+    bool sampleSlow(DebugTag tag);
+    void applyTagConfig(TagState& state);
+    void writerLoop();
+    bool writeOne(Cell& cell);
+
+    DebugRecorderConfig config_;
+    std::atomic<bool> enabled_{false};
+
+    std::mutex tags_mutex_;
+    TagState tags_[MAX_TAGS];
+    std::atomic<int> tag_count_{0};
+
+    std::unique_ptr<Cell[]> cells_;
+    size_t mask_ = 0;
+    std::atomic<size_t> enqueue_pos_{0};
+    size_t dequeue_pos_ = 0;                // writer only
+
+    std::thread writer_;
+    std::atomic<bool> running_{false};
+    uint64_t file_counter_ = 0;             // writer only
+
+    std::atomic<uint64_t> recorded_{0};
+    std::atomic<uint64_t> dropped_{0};
+    std::atomic<uint64_t> failed_{0};
+    std::atomic<uint64_t> bytes_{0};
+    std::atomic<bool> over_budget_{false};
+};
+
+// The process-wide recorder used by the OCR and plate preprocessing code
+DebugRecorder& debug_recorder();
+
+#endif // DEBUG_RECORDER_HPP
@@ -0,0 +1,50 @@
+#ifndef EVENT_NOTIFIER_HPP
+#define EVENT_NOTIFIER_HPP
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+
+// --- Event count for blocking consumers ---
+// One notifier can be attached to several queues so a thread sleeps until
+// any of them has work. Usage, without lost wakeups:
+//
+//     uint64_t key = notifier.prepare_wait();
+//     if (!queue_a.try_pop(a) && !queue_b.try_pop(b)) {
+//         notifier.wait(key, timeout);
+//     }
+//
+// notify() is lock-free unless a thread is actually sleeping.
+class EventNotifier {
+public:
+    uint64_t prepare_wait() const {
+        return epoch_.load();
+    }
+
+    void notify() {
+        epoch_.fetch_add(1);
+        if (waiters_.load() > 0) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            cond_.notify_all();
+        }
+    }
+
+    // Returns false on timeout
+    bool wait(uint64_t key, std::chrono::milliseconds timeout) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        waiters_.fetch_add(1);
+        bool woken = cond_.wait_for(lock, timeout, [this, key] { return epoch_.load() != key; });
+        waiters_.fetch_sub(1);
+        return woken;
+    }
+
+private:
+    std::atomic<uint64_t> epoch_{0};
+    std::atomic<int> waiters_{0};
+    std::mutex mutex_;
+    std::condition_variable cond_;
+};
+
+#endif // EVENT_NOTIFIER_HPP
@@ -0,0 +1,165 @@
+#include "ocr_bench.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <random>
+
+#include "ctc_decode.hpp"
+
+#include <opencv2/imgcodecs.hpp>
+
+namespace {
+
+double percentile(const std::vector<double>& sorted, double p) {
+    if (sorted.empty()) {
+        return 0.0;
+    }
+    size_t rank = static_cast<size_t>(std::ceil(p / 100.0 * sorted.size()));
+    return sorted[std::min(sorted.size(), std::max<size_t>(rank, 1)) - 1];
+}
+
+// The decoder and confidence pass ctc_greedy_decode replaced, kept as the
+// reference: one full argmax scan each
+std::vector<int> two_pass_decode(const float* logits, int time, int classes) {
+    std::vector<int> result;
+    int prev = -1;
+    for (int t = 0; t < time; ++t) {
+        int max_index = 0;
+        float max_val = logits[t * classes];
+        for (int c = 1; c < classes; ++c) {
+            float val = logits[t * classes + c];
+            if (val > max_val) {
+                max_val = val;
+                max_index = c;
+            }
+        }
+        if (max_index != prev && max_index != 0) {
+            result.push_back(max_index);
+        }
+        prev = max_index;
+    }
+    return result;
+}
+
+float two_pass_confidence(const float* logits, int time, int classes, const std::string& mode) {
+    std::vector<float> confidences;
+    for (int t = 0; t < time; ++t) {
+        int max_index = 0;
+        float max_val = logits[t * classes];
+        for (int c = 1; c < classes; ++c) {
+            float val = logits[t * classes + c];
+            if (val > max_val) {
+                max_val = val;
+                max_index = c;
+            }
+        }
+        if (max_index == 0) continue;
+        confidences.push_back(std::exp(max_val));
+    }
+    if (confidences.empty()) {
+        return 0.0f;
+    }
+    if (mode == "min") {
+        return *std::min_element(confidences.begin(), confidences.end());
+    }
+    return std::accumulate(confidences.begin(), confidences.end(), 0.0f) / confidences.size();
+}
+
+} // namespace
+
+int run_ctc_decode_bench(int time, int classes, int iterations) {
+    if (time <= 0 || classes <= 1 || iterations <= 0) {
+        std::cerr << "[BENCH] time, classes (> 1) and iterations must be positive" << std::endl;
+        return 1;
+    }
+
+    // Plate-like outputs: mostly blank, a peaked class every few steps
+    const int samples = 64;
+    std::mt19937 rng(1234);
+    std::uniform_real_distribution<float> noise(-12.0f, -4.0f);
+    std::uniform_int_distribution<int> label(1, classes - 1);
+    std::vector<float> logits(static_cast<size_t>(samples) * time * classes);
+    for (size_t row = 0; row < logits.size() / classes; ++row) {
+        float* p = logits.data() + row * classes;
+        for (int c = 0; c < classes; ++c) {
+            p[c] = noise(rng);
+        }
+        p[row % 3 == 0 ? label(rng) : 0] = -0.05f - (rng() % 100) * 0.001f;
+    }
+
+    size_t mismatches = 0;
+    CtcDecodeResult fused;
+    for (int s = 0; s < samples; ++s) {
+        const float* sample = logits.data() + static_cast<size_t>(s) * time * classes;
+        ctc_greedy_decode(sample, time, classes, fused);
+        if (fused.indices != two_pass_decode(sample, time, classes) ||
+            fused.min_confidence != two_pass_confidence(sample, time, classes, "min") ||
+            fused.mean_confidence != two_pass_confidence(sample, time, classes, "mean")) {
+            mismatches++;
+        }
+    }
+
+    std::vector<double> two_pass_ms;
+    std::vector<double> fused_ms;
+    size_t checksum = 0;
+    for (int it = 0; it < iterations; ++it) {
+        for (int s = 0; s < samples; ++s) {
+            const float* sample = logits.data() + static_cast<size_t>(s) * time * classes;
+            auto start = std::chrono::steady_clock::now();
+            std::vector<int> indices = two_pass_decode(sample, time, classes);
+            float confidence = two_pass_confidence(sample, time, classes, "min");
+            two_pass_ms.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+            checksum += indices.size() + (confidence > 0.5f);
+
+            start = std::chrono::steady_clock::now();
+            ctc_greedy_decode(sample, time, classes, fused);
+            fused_ms.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+            checksum += fused.indices.size() + (fused.min_confidence > 0.5f);
+        }
+    }
+
+    std::cout << "[BENCH] ctc: [" << time << " x " << classes << "], " << samples << " outputs, "
+              << iterations << " iterations" << std::endl;
+    print_latency("two-pass", summarize_latency(two_pass_ms));
+    print_latency("fused   ", summarize_latency(fused_ms));
+    std::cout << "  mismatches: " << mismatches << " (checksum " << checksum << ")" << std::endl;
+    return mismatches == 0 ? 0 : 2;
+}
+
+LatencySummary summarize_latency(std::vector<double>& samples_ms) {
+    std::sort(samples_ms.begin(), samples_ms.end());
+    double sum = std::accumulate(samples_ms.begin(), samples_ms.end(), 0.0);
+    return {
+        samples_ms.size(),
+        samples_ms.empty() ? 0.0 : sum / samples_ms.size(),
+        percentile(samples_ms, 50.0),
+        percentile(samples_ms, 90.0),
+        percentile(samples_ms, 99.0),
+        samples_ms.empty() ? 0.0 : samples_ms.back()
+    };
+}
+
+void print_latency(const char* name, const LatencySummary& summary) {
+    std::cout << "  " << name << ": n=" << summary.count
+              << " mean " << summary.mean_ms << " ms"
+              << " p50 " << summary.p50_ms
+              << " p90 " << summary.p90_ms
+              << " p99 " << summary.p99_ms
+              << " max " << summary.max_ms << std::endl;
+}
+
+std::vector<cv::Mat> load_crop_images(const std::string& dir) {
+    std::vector<cv::Mat> images;
+    for (const char* pattern : {"/*.png", "/*.jpg", "/*.jpeg", "/*.bmp"}) {
+        std::vector<cv::String> files;
+        cv::glob(dir + pattern, files, false);
+        for (const cv::String& file : files) {
+            cv::Mat image = cv::imread(file, cv::IMREAD_COLOR);
+            if (!image.empty()) {
+                images.push_back(image);
+            }
+        }
+    }
+    return images;
+}
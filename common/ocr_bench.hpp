@@ -0,0 +1,66 @@
+#ifndef OCR_BENCH_HPP
+#define OCR_BENCH_HPP
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <opencv2/core.hpp>
+
+struct LatencySummary {
+    size_t count;
+    double mean_ms;
+    double p50_ms;
+    double p90_ms;
+    double p99_ms;
+    double max_ms;
+};
+
+// Sorts `samples_ms` in place
+LatencySummary summarize_latency(std::vector<double>& samples_ms);
+void print_latency(const char* name, const LatencySummary& summary);
+
+// Fused ctc_greedy_decode vs the former two-pass decoder + confidence on
+// random log-probabilities of shape [time x classes]; returns 2 if their
+// labels or confidences differ
+int run_ctc_decode_bench(int time, int classes, int iterations);
+
+// All images in `dir` (png/jpg/bmp), as 8-bit BGR
+std::vector<cv::Mat> load_crop_images(const std::string& dir);
+
+// --- OCR latency benchmark ---
+// Runs every crop through `ocr.run_ocr()` `iterations` times after one
+// warm-up pass and reports invoke-only latency (Ocr::lastInvokeMs()) and
+// end-to-end latency including preprocessing.
+template<typename Ocr>
+int run_ocr_latency_bench(Ocr& ocr, const std::vector<cv::Mat>& crops, int iterations) {
+    if (crops.empty()) {
+        std::cerr << "[BENCH] No crops to run" << std::endl;
+        return 1;
+    }
+
+    for (const cv::Mat& crop : crops) {
+        ocr.run_ocr(crop); // warm-up: arena planning, delegate packing, caches
+    }
+
+    std::vector<double> invoke_ms;
+    std::vector<double> total_ms;
+    invoke_ms.reserve(crops.size() * iterations);
+    total_ms.reserve(crops.size() * iterations);
+
+    for (int it = 0; it < iterations; ++it) {
+        for (const cv::Mat& crop : crops) {
+            auto start = std::chrono::steady_clock::now();
+            ocr.run_ocr(crop);
+            total_ms.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+            invoke_ms.push_back(ocr.lastInvokeMs());
+        }
+    }
+
+    print_latency("invoke", summarize_latency(invoke_ms));
+    print_latency("run_ocr", summarize_latency(total_ms));
+    return 0;
+}
+
+#endif // OCR_BENCH_HPP
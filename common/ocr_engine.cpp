@@ -0,0 +1,90 @@
+#include "ocr_engine.hpp"
+
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#include <tensorflow/lite/kernels/register.h>
+#include <tensorflow/lite/delegates/xnnpack/xnnpack_delegate.h>
+
+#include "json.hpp"
+
+bool load_ocr_engine_config(const std::string& path, OcrEngineConfig& config) {
+    std::ifstream file(path);
+    if (!file) {
+        return false;
+    }
+
+    OcrEngineConfig loaded = config;
+    try {
+        nlohmann::json j = nlohmann::json::parse(file);
+        loaded.threads = j.value("threads", loaded.threads);
+        loaded.xnnpack = j.value("xnnpack", loaded.xnnpack);
+        loaded.fp16 = j.value("fp16", loaded.fp16);
+
+        std::string allocation = j.value("allocation", std::string());
+        if (allocation == "arena") {
+            loaded.allocation = OcrAllocation::Arena;
+        } else if (allocation == "release_dynamic") {
+            loaded.allocation = OcrAllocation::ReleaseDynamic;
+        } else if (!allocation.empty()) {
+            std::cerr << "[OCR] Unknown allocation \"" << allocation << "\" in " << path
+                      << " (arena|release_dynamic)" << std::endl;
+        }
+    } catch (const nlohmann::json::exception& e) {
+        std::cerr << "[OCR] Failed to parse " << path << ": " << e.what() << std::endl;
+        return false;
+    }
+
+    config = loaded;
+    return true;
+}
+
+std::string describe_ocr_engine_config(const OcrEngineConfig& config) {
+    std::ostringstream out;
+    out << "threads=" << config.threads
+        << " xnnpack=" << (config.xnnpack ? "on" : "off")
+        << " fp16=" << (config.fp16 ? "on" : "off")
+        << " allocation=" << (config.allocation == OcrAllocation::Arena ? "arena" : "release_dynamic");
+    return out.str();
+}
+
+std::unique_ptr<tflite::Interpreter> build_ocr_interpreter(const tflite::FlatBufferModel& model,
+                                                          const OcrEngineConfig& config) {
+    std::unique_ptr<tflite::Interpreter> interpreter;
+
+    // The stock resolver may apply XNNPACK on its own; keep the choice explicit
+    tflite::ops::builtin::BuiltinOpResolverWithoutDefaultDelegates resolver;
+    tflite::InterpreterBuilder builder(model, resolver);
+    builder.SetNumThreads(config.threads);
+    if (builder(&interpreter) != kTfLiteOk || !interpreter) {
+        std::cerr << "[OCR] Failed to build interpreter" << std::endl;
+        return nullptr;
+    }
+
+    interpreter->SetAllowFp16PrecisionForFp32(config.fp16);
+
+    if (config.xnnpack) {
+        TfLiteXNNPackDelegateOptions options = TfLiteXNNPackDelegateOptionsDefault();
+        options.num_threads = config.threads > 0 ? config.threads : 1;
+#ifdef TFLITE_XNNPACK_DELEGATE_FLAG_FORCE_FP16
+        if (config.fp16) {
+            options.flags |= TFLITE_XNNPACK_DELEGATE_FLAG_FORCE_FP16;
+        }
+#endif
+        tflite::Interpreter::TfLiteDelegatePtr delegate(TfLiteXNNPackDelegateCreate(&options),
+                                                        TfLiteXNNPackDelegateDelete);
+        if (interpreter->ModifyGraphWithDelegate(std::move(delegate)) != kTfLiteOk) {
+            std::cerr << "[OCR] XNNPACK delegate not applied, using builtin kernels" << std::endl;
+        }
+    }
+
+    if (interpreter->AllocateTensors() != kTfLiteOk) {
+        std::cerr << "[OCR] Failed to allocate tensors" << std::endl;
+        return nullptr;
+    }
+    if (config.allocation == OcrAllocation::ReleaseDynamic) {
+        interpreter->EnsureDynamicTensorsAreReleased();
+    }
+    return interpreter;
+}
@@ -0,0 +1,46 @@
+#ifndef OCR_ENGINE_HPP
+#define OCR_ENGINE_HPP
+
+#include <memory>
+#include <string>
+
+#include <tensorflow/lite/interpreter.h>
+#include <tensorflow/lite/model.h>
+
+// How the TFLite tensor arena is managed
+enum class OcrAllocation {
+    Arena,              // plan once, keep everything (lowest latency)
+    ReleaseDynamic      // free dynamic tensors after each invoke (lowest memory)
+};
+
+// Execution settings shared by every OCR engine (onvif_streamer and
+// yolo_lp_detector). Loaded from a JSON file such as:
+//
+//   {
+//     "threads": 4,
+//     "xnnpack": true,
+//     "fp16": false,
+//     "allocation": "arena"
+//   }
+//
+// Missing keys keep their defaults.
+struct OcrEngineConfig {
+    int threads = 4;                // interpreter / XNNPACK threads, -1: TFLite default
+    bool xnnpack = true;            // apply the XNNPACK delegate (NEON kernels)
+    bool fp16 = false;              // allow fp16 arithmetic for fp32 models
+    OcrAllocation allocation = OcrAllocation::Arena;
+};
+
+// Returns false (and keeps `config` untouched) if the file cannot be read
+// or parsed
+bool load_ocr_engine_config(const std::string& path, OcrEngineConfig& config);
+
+std::string describe_ocr_engine_config(const OcrEngineConfig& config);
+
+// Build an interpreter for `model` with the given settings and allocate
+// its tensors. The delegate, if any, is owned by the interpreter. Several
+// interpreters may share one model.
+std::unique_ptr<tflite::Interpreter> build_ocr_interpreter(const tflite::FlatBufferModel& model,
+                                                          const OcrEngineConfig& config);
+
+#endif // OCR_ENGINE_HPP
@@ -0,0 +1,93 @@
+#include "ocr_tensor.hpp"
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#include <opencv2/core.hpp>
+
+namespace {
+
+// Bytes of one batch entry of `tensor`
+size_t batch_entry_bytes(const TfLiteTensor* tensor) {
+    int batch = tensor->dims->size > 0 ? tensor->dims->data[0] : 1;
+    return batch > 0 ? tensor->bytes / batch : tensor->bytes;
+}
+
+// Quantized value of the real value `v`, as a double
+double quantize(const TfLiteTensor* tensor, double v) {
+    return std::round(v / tensor->params.scale) + tensor->params.zero_point;
+}
+
+} // namespace
+
+bool ocr_tensor_type_supported(const TfLiteTensor* tensor) {
+    return tensor && (tensor->type == kTfLiteFloat32 || tensor->type == kTfLiteUInt8 ||
+                      tensor->type == kTfLiteInt8);
+}
+
+const char* ocr_tensor_type_name(const TfLiteTensor* tensor) {
+    if (!tensor) {
+        return "none";
+    }
+    switch (tensor->type) {
+    case kTfLiteFloat32: return "float32";
+    case kTfLiteUInt8: return "uint8";
+    case kTfLiteInt8: return "int8";
+    default: return "unsupported";
+    }
+}
+
+void write_ocr_input(const cv::Mat& image, double alpha, double beta, bool clamp01,
+                     TfLiteTensor* tensor, int batch_index) {
+    uint8_t* entry = reinterpret_cast<uint8_t*>(tensor->data.raw) + batch_entry_bytes(tensor) * batch_index;
+
+    if (tensor->type == kTfLiteFloat32) {
+        cv::Mat input(image.rows, image.cols, CV_32FC1, entry);
+        image.convertTo(input, CV_32FC1, alpha, beta);
+        if (clamp01) {
+            cv::min(input, 1.0, input);
+            cv::max(input, 0.0, input);
+        }
+        return;
+    }
+
+    // q = round(real / scale) + zero_point, folded into one saturating
+    // convertTo: pixel * alpha / scale + (beta / scale + zero_point)
+    int type = tensor->type == kTfLiteInt8 ? CV_8SC1 : CV_8UC1;
+    double scale = tensor->params.scale > 0.0f ? tensor->params.scale : 1.0;
+    cv::Mat input(image.rows, image.cols, type, entry);
+    image.convertTo(input, type, alpha / scale, beta / scale + tensor->params.zero_point);
+    if (clamp01) {
+        cv::min(input, quantize(tensor, 1.0), input);
+        cv::max(input, quantize(tensor, 0.0), input);
+    }
+}
+
+void clear_ocr_input(TfLiteTensor* tensor, int batch_index) {
+    size_t bytes = batch_entry_bytes(tensor);
+    std::memset(reinterpret_cast<uint8_t*>(tensor->data.raw) + bytes * batch_index, 0, bytes);
+}
+
+const float* read_ocr_output(const TfLiteTensor* tensor, size_t offset, size_t count,
+                             std::vector<float>& scratch) {
+    if (tensor->type == kTfLiteFloat32) {
+        return tensor->data.f + offset;
+    }
+
+    scratch.resize(count);
+    float scale = tensor->params.scale;
+    int32_t zero_point = tensor->params.zero_point;
+    if (tensor->type == kTfLiteInt8) {
+        const int8_t* q = tensor->data.int8 + offset;
+        for (size_t i = 0; i < count; ++i) {
+            scratch[i] = (q[i] - zero_point) * scale;
+        }
+    } else {
+        const uint8_t* q = tensor->data.uint8 + offset;
+        for (size_t i = 0; i < count; ++i) {
+            scratch[i] = (q[i] - zero_point) * scale;
+        }
+    }
+    return scratch.data();
+}
@@ -0,0 +1,35 @@
+#ifndef OCR_TENSOR_HPP
+#define OCR_TENSOR_HPP
+
+#include <cstddef>
+#include <vector>
+
+#include <opencv2/core.hpp>
+#include <tensorflow/lite/c/common.h>
+
+// --- OCR model tensors of any supported element type ---
+// float32 models take normalized pixels as is; int8/uint8 (fully integer
+// quantized) models get them quantized with the tensor's scale/zero point,
+// and their logits are dequantized before CTC decoding. Shared by the OCR
+// engines of onvif_streamer and yolo_lp_detector.
+
+// float32, uint8 or int8
+bool ocr_tensor_type_supported(const TfLiteTensor* tensor);
+const char* ocr_tensor_type_name(const TfLiteTensor* tensor);
+
+// Writes the 8-bit `image` (the model's input size) as image * alpha + beta
+// into batch entry `batch_index` of the input tensor, quantizing for integer
+// models. With `clamp01` the normalized values are limited to [0, 1].
+void write_ocr_input(const cv::Mat& image, double alpha, double beta, bool clamp01,
+                     TfLiteTensor* tensor, int batch_index);
+
+// Zero batch entry `batch_index` (padding; the result is discarded)
+void clear_ocr_input(TfLiteTensor* tensor, int batch_index);
+
+// `count` float logits starting at element `offset` of the output tensor.
+// Float outputs are returned in place; quantized ones are dequantized into
+// `scratch`, which is reused between calls.
+const float* read_ocr_output(const TfLiteTensor* tensor, size_t offset, size_t count,
+                             std::vector<float>& scratch);
+
+#endif // OCR_TENSOR_HPP
@@ -0,0 +1,263 @@
+#ifndef SPSC_RING_HPP
+#define SPSC_RING_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "event_notifier.hpp"
+
+// What push() does when the ring is full
+enum class OverflowPolicy {
+    DropOldest,       // discard the oldest queued item (live video: newest wins)
+    DropNewest,       // discard the item being pushed
+    BlockWithTimeout  // wait for the consumer, then drop the pushed item on timeout
+};
+
+struct QueueStats {
+    size_t capacity;
+    size_t occupancy;
+    size_t high_watermark;
+    uint64_t pushed;
+    uint64_t popped;
+    uint64_t dropped_oldest;
+    uint64_t dropped_newest;
+    uint64_t timeouts;
+};
+
+// Slot lifecycle hooks. Slots are created once with make(), returned to a
+// reusable state with reset() and released with dispose(). Specialize for
+// owning handle types (AVPacket*, AVFrame*, ...) so they are recycled
+// instead of reallocated for every item.
+template<typename T>
+struct RingSlotTraits {
+    static T make() { return T(); }
+    static void reset(T& value) { value = T(); }
+    static void dispose(T&) {}
+};
+
+// --- Bounded single-producer/single-consumer ring ---
+// Items are exchanged with std::swap: push() hands the item to a slot and
+// gives the caller back the slot's (reset) previous content, pop() does the
+// reverse. Nothing is allocated after construction.
+//
+// Each slot carries a sequence number (Vyukov-style), so the producer can
+// safely claim the oldest slot itself to implement DropOldest while the
+// consumer is popping.
+template<typename T, typename Traits = RingSlotTraits<T>>
+class SpscRing {
+public:
+    SpscRing(size_t capacity, OverflowPolicy policy,
+             std::chrono::milliseconds block_timeout = std::chrono::milliseconds(20))
+        : capacity_(capacity ? capacity : 1), policy_(policy), block_timeout_(block_timeout),
+          slots_(capacity_), scratch_(Traits::make()) {
+        for (size_t i = 0; i < capacity_; ++i) {
+            slots_[i].seq.store(i, std::memory_order_relaxed);
+            slots_[i].value = Traits::make();
+        }
+    }
+
+    ~SpscRing() {
+        for (auto& slot : slots_) {
+            Traits::reset(slot.value);
+            Traits::dispose(slot.value);
+        }
+        Traits::dispose(scratch_);
+    }
+
+    SpscRing(const SpscRing&) = delete;
+    SpscRing& operator=(const SpscRing&) = delete;
+
+    // Wake the consumer through `notifier` on every successful push
+    void set_notifier(EventNotifier* notifier) { notifier_ = notifier; }
+
+    // Producer side. Returns false if the item was dropped; in every case
+    // `value` comes back reset and ready to be refilled.
+    bool push(T& value) {
+        std::chrono::steady_clock::time_point deadline{};
+        bool waiting = false;
+
+        for (;;) {
+            if (try_enqueue(value)) {
+                pushed_.fetch_add(1, std::memory_order_relaxed);
+                update_high_watermark();
+                if (notifier_) {
+                    notifier_->notify();
+                }
+                return true;
+            }
+
+            switch (policy_) {
+            case OverflowPolicy::DropOldest:
+                if (try_dequeue(scratch_)) {
+                    Traits::reset(scratch_);
+                    dropped_oldest_.fetch_add(1, std::memory_order_relaxed);
+                } else {
+                    std::this_thread::yield(); // consumer is mid-pop, slot frees shortly
+                }
+                break;
+
+            case OverflowPolicy::DropNewest:
+                Traits::reset(value);
+                dropped_newest_.fetch_add(1, std::memory_order_relaxed);
+                return false;
+
+            case OverflowPolicy::BlockWithTimeout:
+                if (!waiting) {
+                    deadline = std::chrono::steady_clock::now() + block_timeout_;
+                    waiting = true;
+                }
+                if (!wait_for_space(deadline)) {
+                    Traits::reset(value);
+                    timeouts_.fetch_add(1, std::memory_order_relaxed);
+                    dropped_newest_.fetch_add(1, std::memory_order_relaxed);
+                    return false;
+                }
+                break;
+            }
+        }
+    }
+
+    // Consumer side. `value` is reset and swapped with the oldest item.
+    bool try_pop(T& value) {
+        Traits::reset(value);
+        if (!try_dequeue(value)) {
+            return false;
+        }
+        popped_.fetch_add(1, std::memory_order_relaxed);
+        // Pairs with the fence in wait_for_space: either this load sees the
+        // producer's flag, or the producer's recheck sees the freed slot
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (producer_waiting_.load(std::memory_order_relaxed)) {
+            std::lock_guard<std::mutex> lock(space_mutex_);
+            space_cond_.notify_one();
+        }
+        return true;
+    }
+
+    size_t size() const {
+        size_t head = dequeue_pos_.load(std::memory_order_acquire);
+        size_t tail = enqueue_pos_.load(std::memory_order_acquire);
+        return tail > head ? std::min(tail - head, capacity_) : 0;
+    }
+
+    bool empty() const { return size() == 0; }
+    size_t capacity() const { return capacity_; }
+
+    // Total number of items discarded for any reason
+    uint64_t drops() const {
+        return dropped_oldest_.load(std::memory_order_relaxed) +
+               dropped_newest_.load(std::memory_order_relaxed);
+    }
+
+    QueueStats stats() const {
+        return {
+            capacity_,
+            size(),
+            high_watermark_.load(std::memory_order_relaxed),
+            pushed_.load(std::memory_order_relaxed),
+            popped_.load(std::memory_order_relaxed),
+            dropped_oldest_.load(std::memory_order_relaxed),
+            dropped_newest_.load(std::memory_order_relaxed),
+            timeouts_.load(std::memory_order_relaxed)
+        };
+    }
+
+private:
+    struct Slot {
+        std::atomic<size_t> seq{0};
+        T value;
+    };
+
+    bool try_enqueue(T& value) {
+        size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+        Slot& slot = slots_[pos % capacity_];
+        if (slot.seq.load(std::memory_order_acquire) != pos) {
+            return false; // full, or the consumer has not released this slot yet
+        }
+        std::swap(slot.value, value);
+        slot.seq.store(pos + 1, std::memory_order_release);
+        enqueue_pos_.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Called by the consumer, and by the producer when dropping the oldest item
+    bool try_dequeue(T& value) {
+        size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+        Slot* slot;
+        for (;;) {
+            slot = &slots_[pos % capacity_];
+            size_t seq = slot->seq.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+            if (diff == 0) {
+                if (dequeue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false; // empty
+            } else {
+                pos = dequeue_pos_.load(std::memory_order_relaxed);
+            }
+        }
+        std::swap(slot->value, value);
+        slot->seq.store(pos + capacity_, std::memory_order_release);
+        return true;
+    }
+
+    // The slot try_enqueue() would claim next has been released by the consumer
+    bool slot_free() const {
+        size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+        return slots_[pos % capacity_].seq.load(std::memory_order_acquire) == pos;
+    }
+
+    // Announce the wait, fence, then recheck the slot before sleeping. The
+    // consumer releases the slot, fences and only then reads the flag, so a
+    // pop that races with this call is either seen by the recheck or
+    // notifies (under space_mutex_, after the predicate was checked).
+    bool wait_for_space(std::chrono::steady_clock::time_point deadline) {
+        std::unique_lock<std::mutex> lock(space_mutex_);
+        producer_waiting_.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        bool has_space = space_cond_.wait_until(lock, deadline, [this] { return slot_free(); });
+        producer_waiting_.store(false, std::memory_order_relaxed);
+        return has_space;
+    }
+
+    void update_high_watermark() {
+        size_t occupancy = size();
+        size_t prev = high_watermark_.load(std::memory_order_relaxed);
+        while (occupancy > prev &&
+               !high_watermark_.compare_exchange_weak(prev, occupancy, std::memory_order_relaxed)) {
+        }
+    }
+
+    const size_t capacity_;
+    const OverflowPolicy policy_;
+    const std::chrono::milliseconds block_timeout_;
+    std::vector<Slot> slots_;
+    T scratch_; // producer-owned landing spot for DropOldest
+    EventNotifier* notifier_ = nullptr;
+
+    alignas(64) std::atomic<size_t> enqueue_pos_{0};
+    alignas(64) std::atomic<size_t> dequeue_pos_{0};
+
+    std::atomic<bool> producer_waiting_{false};
+    std::mutex space_mutex_;
+    std::condition_variable space_cond_;
+
+    std::atomic<size_t> high_watermark_{0};
+    std::atomic<uint64_t> pushed_{0};
+    std::atomic<uint64_t> popped_{0};
+    std::atomic<uint64_t> dropped_oldest_{0};
+    std::atomic<uint64_t> dropped_newest_{0};
+    std::atomic<uint64_t> timeouts_{0};
+};
+
+#endif // SPSC_RING_HPP
@@ -0,0 +1,446 @@
+#include "bench.hpp"
+#include "parser.hpp"
+#include "parser_dom.hpp"
+#include "ocr.hpp"
+#include "ocr_bench.hpp"
+#include "ocr_engine.hpp"
+#include "sharpness.hpp"
+#include "best_shot.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace {
+
+using bench_clock = std::chrono::steady_clock;
+
+struct ParserRun {
+    double seconds = 0.0;
+    size_t documents = 0;
+    size_t objects = 0;
+    std::vector<MetadataResult> results; // first iteration only
+};
+
+// Replays the recording in `chunk`-sized packets, like the RTSP demuxer
+// hands over RTP payloads
+template<typename Parser>
+ParserRun replay(const std::vector<uint8_t>& data, size_t chunk, int iterations) {
+    ParserRun run;
+    MetadataResult result;
+    for (int it = 0; it < iterations; ++it) {
+        Parser parser;
+        int64_t pts = 0;
+        auto start = bench_clock::now();
+        for (size_t off = 0; off < data.size(); off += chunk, ++pts) {
+            size_t size = std::min(chunk, data.size() - off);
+            parser.processBytes(data.data() + off, size, pts);
+            while (parser.popCompletedResult(result)) {
+                run.documents++;
+                run.objects += result.objects.size();
+                if (it == 0) {
+                    run.results.push_back(result);
+                }
+            }
+        }
+        run.seconds += std::chrono::duration<double>(bench_clock::now() - start).count();
+    }
+    return run;
+}
+
+bool same_object(const Object& a, const Object& b) {
+    const float eps = 1e-3f;
+    return a.objectId == b.objectId && a.type == b.type &&
+           std::fabs(a.confidence - b.confidence) < eps &&
+           std::fabs(a.boundingBox.left - b.boundingBox.left) < eps &&
+           std::fabs(a.boundingBox.top - b.boundingBox.top) < eps &&
+           std::fabs(a.boundingBox.right - b.boundingBox.right) < eps &&
+           std::fabs(a.boundingBox.bottom - b.boundingBox.bottom) < eps &&
+           std::fabs(a.centerOfGravity.x - b.centerOfGravity.x) < eps &&
+           std::fabs(a.centerOfGravity.y - b.centerOfGravity.y) < eps;
+}
+
+size_t count_mismatches(const std::vector<MetadataResult>& a, const std::vector<MetadataResult>& b) {
+    size_t mismatches = 0;
+    size_t n = std::max(a.size(), b.size());
+    for (size_t i = 0; i < n; ++i) {
+        if (i >= a.size() || i >= b.size() || a[i].pts != b[i].pts ||
+            a[i].objects.size() != b[i].objects.size()) {
+            mismatches++;
+            continue;
+        }
+        for (size_t j = 0; j < a[i].objects.size(); ++j) {
+            if (!same_object(a[i].objects[j], b[i].objects[j])) {
+                mismatches++;
+                break;
+            }
+        }
+    }
+    return mismatches;
+}
+
+void print_run(const char* name, const ParserRun& run, size_t bytes, int iterations) {
+    double mb = static_cast<double>(bytes) * iterations / (1024.0 * 1024.0);
+    double per_doc_us = run.documents ? run.seconds * 1e6 / run.documents : 0.0;
+    std::cout << "  " << name << ": " << run.seconds * 1000.0 << " ms, "
+              << mb / run.seconds << " MB/s, "
+              << per_doc_us << " us/document, "
+              << run.objects / iterations << " plates" << std::endl;
+}
+
+// --bench parser <metadata.bin> [chunk_bytes] [iterations]
+int bench_parser(int argc, char* argv[]) {
+    if (argc < 1) {
+        std::cerr << "Usage: --bench parser <metadata.bin> [chunk_bytes] [iterations]" << std::endl;
+        return 1;
+    }
+    std::ifstream file(argv[0], std::ios::binary);
+    if (!file) {
+        std::cerr << "Failed to open " << argv[0] << std::endl;
+        return 1;
+    }
+    std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    size_t chunk = argc > 1 ? static_cast<size_t>(atol(argv[1])) : 1400;
+    int iterations = argc > 2 ? atoi(argv[2]) : 20;
+    if (chunk == 0 || iterations <= 0) {
+        std::cerr << "chunk_bytes and iterations must be positive" << std::endl;
+        return 1;
+    }
+
+    std::cout << "[BENCH] parser: " << data.size() << " bytes, "
+              << chunk << " byte packets, " << iterations << " iterations" << std::endl;
+
+    ParserRun dom = replay<DomMetadataParser>(data, chunk, iterations);
+    ParserRun streaming = replay<MetadataParser>(data, chunk, iterations);
+
+    print_run("tinyxml2 ", dom, data.size(), iterations);
+    print_run("streaming", streaming, data.size(), iterations);
+    if (streaming.seconds > 0.0) {
+        std::cout << "  speedup: " << dom.seconds / streaming.seconds << "x" << std::endl;
+    }
+
+    size_t mismatches = count_mismatches(dom.results, streaming.results);
+    std::cout << "  documents: " << dom.results.size() << " / " << streaming.results.size()
+              << ", mismatches: " << mismatches << std::endl;
+    return mismatches == 0 ? 0 : 2;
+}
+
+// --bench ocr <crop_dir> [engine.json] [iterations]
+int bench_ocr(int argc, char* argv[]) {
+    if (argc < 1) {
+        std::cerr << "Usage: --bench ocr <crop_dir> [engine.json] [iterations]" << std::endl;
+        return 1;
+    }
+    OcrEngineConfig config;
+    if (argc > 1 && !load_ocr_engine_config(argv[1], config)) {
+        std::cerr << "Failed to load " << argv[1] << std::endl;
+        return 1;
+    }
+    int iterations = argc > 2 ? atoi(argv[2]) : 10;
+
+    std::vector<cv::Mat> crops = load_crop_images(argv[0]);
+    std::cout << "[BENCH] ocr: " << crops.size() << " crops, " << iterations << " iterations, "
+              << describe_ocr_engine_config(config) << std::endl;
+
+    TFOCR ocr;
+    ocr.load_ocr("model.tflite", "labels.names", config);
+    return run_ocr_latency_bench(ocr, crops, iterations);
+}
+
+// One labelled crop of a best-shot corpus
+struct LabelledCrop {
+    int frame;
+    cv::Mat luma;
+};
+
+// <dir>/<plate>_<frame>.<ext>: crops of one pass of a plate, named by its
+// true number and frame index
+std::map<std::string, std::vector<LabelledCrop>> load_labelled_crops(const std::string& dir) {
+    std::map<std::string, std::vector<LabelledCrop>> tracks;
+    for (const char* pattern : {"/*.png", "/*.jpg", "/*.jpeg", "/*.bmp"}) {
+        std::vector<cv::String> files;
+        cv::glob(dir + pattern, files, false);
+        for (const cv::String& file : files) {
+            std::string name = file.substr(file.find_last_of('/') + 1);
+            name = name.substr(0, name.find_last_of('.'));
+            size_t split = name.find_last_of('_');
+            if (split == std::string::npos) {
+                continue;
+            }
+            cv::Mat luma = cv::imread(file, cv::IMREAD_GRAYSCALE);
+            if (!luma.empty()) {
+                tracks[name.substr(0, split)].push_back({atoi(name.c_str() + split + 1), luma});
+            }
+        }
+    }
+    for (auto& track : tracks) {
+        std::sort(track.second.begin(), track.second.end(),
+                  [](const LabelledCrop& a, const LabelledCrop& b) { return a.frame < b.frame; });
+    }
+    return tracks;
+}
+
+struct SelectionRun {
+    size_t calls = 0;
+    size_t correct_reads = 0;
+    size_t tracks = 0;
+    size_t correct_tracks = 0;  // most frequent read == truth
+};
+
+void print_selection(const char* name, const SelectionRun& run, size_t crops) {
+    std::cout << "  " << name << ": " << run.calls << " OCR calls ("
+              << (crops ? 100.0 * run.calls / crops : 0.0) << "% of crops), read accuracy "
+              << (run.calls ? 100.0 * run.correct_reads / run.calls : 0.0) << "%, plate accuracy "
+              << (run.tracks ? 100.0 * run.correct_tracks / run.tracks : 0.0) << "% ("
+              << run.correct_tracks << "/" << run.tracks << ")" << std::endl;
+}
+
+// --bench bestshot <crop_dir> [shots] [window_frames] [iterations]
+int bench_bestshot(int argc, char* argv[]) {
+    if (argc < 1) {
+        std::cerr << "Usage: --bench bestshot <crop_dir> [shots] [window_frames] [iterations]" << std::endl;
+        return 1;
+    }
+    size_t shots = argc > 1 ? static_cast<size_t>(std::max(1, atoi(argv[1]))) : 1;
+    int window = argc > 2 ? std::max(1, atoi(argv[2])) : 6;
+    int iterations = argc > 3 ? std::max(1, atoi(argv[3])) : 200;
+
+    std::map<std::string, std::vector<LabelledCrop>> tracks = load_labelled_crops(argv[0]);
+    size_t crops = 0;
+    size_t pixels = 0;
+    for (const auto& track : tracks) {
+        for (const LabelledCrop& crop : track.second) {
+            crops++;
+            pixels += crop.luma.total();
+        }
+    }
+    std::cout << "[BENCH] bestshot: " << tracks.size() << " plates, " << crops << " crops, best "
+              << shots << " per " << window << " frames" << std::endl;
+    if (crops == 0) {
+        std::cerr << "[BENCH] No <plate>_<frame> crops in " << argv[0] << std::endl;
+        return 1;
+    }
+
+    // Scoring kernel: vectorized vs scalar, results must match exactly
+    size_t mismatches = 0;
+    double checksum = 0.0;
+    auto start = std::chrono::steady_clock::now();
+    for (int it = 0; it < iterations; ++it) {
+        for (const auto& track : tracks) {
+            for (const LabelledCrop& crop : track.second) {
+                checksum += laplacian_variance_scalar(crop.luma.data, static_cast<int>(crop.luma.step), crop.luma.cols, crop.luma.rows);
+            }
+        }
+    }
+    double scalar_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    start = std::chrono::steady_clock::now();
+    for (int it = 0; it < iterations; ++it) {
+        for (const auto& track : tracks) {
+            for (const LabelledCrop& crop : track.second) {
+                checksum -= laplacian_variance(crop.luma.data, static_cast<int>(crop.luma.step), crop.luma.cols, crop.luma.rows);
+            }
+        }
+    }
+    double simd_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    for (const auto& track : tracks) {
+        for (const LabelledCrop& crop : track.second) {
+            int stride = static_cast<int>(crop.luma.step);
+            if (laplacian_variance(crop.luma.data, stride, crop.luma.cols, crop.luma.rows) !=
+                laplacian_variance_scalar(crop.luma.data, stride, crop.luma.cols, crop.luma.rows)) {
+                mismatches++;
+            }
+        }
+    }
+    double mpix = static_cast<double>(pixels) * iterations / 1e6;
+    std::cout << "  laplacian scalar: " << mpix / scalar_seconds << " MPix/s, "
+              << scalar_seconds * 1e6 / (crops * iterations) << " us/crop" << std::endl;
+    std::cout << "  laplacian simd:   " << mpix / simd_seconds << " MPix/s, "
+              << simd_seconds * 1e6 / (crops * iterations) << " us/crop"
+              << " (" << scalar_seconds / simd_seconds << "x, mismatches " << mismatches
+              << ", checksum " << checksum << ")" << std::endl;
+
+    // OCR every crop vs the best `shots` crops of every window
+    TFOCR ocr;
+    ocr.load_ocr("model.tflite", "labels.names", OcrEngineConfig());
+    if (!ocr.loaded()) {
+        return 1;
+    }
+
+    SelectionRun all;
+    SelectionRun best;
+    for (const auto& track : tracks) {
+        const std::string& truth = track.first;
+        const std::vector<LabelledCrop>& frames = track.second;
+        std::map<std::string, int> all_votes;
+        std::map<std::string, int> best_votes;
+        std::vector<std::pair<float, size_t>> ranked;
+        std::vector<std::string> reads(frames.size());
+
+        for (size_t begin = 0; begin < frames.size(); begin += window) {
+            size_t end = std::min(frames.size(), begin + static_cast<size_t>(window));
+            ranked.clear();
+            for (size_t i = begin; i < end; i++) {
+                const cv::Mat& luma = frames[i].luma;
+                reads[i] = ocr.run_ocr_luma(luma.data, static_cast<int>(luma.step), luma.cols, luma.rows, true).label;
+                all.calls++;
+                if (reads[i] == truth) {
+                    all.correct_reads++;
+                }
+                if (!reads[i].empty()) {
+                    all_votes[reads[i]]++;
+                }
+                ranked.push_back({best_shot_score(luma.data, static_cast<int>(luma.step), luma.cols, luma.rows, 0.0f, 0.0), i});
+            }
+
+            std::sort(ranked.begin(), ranked.end(), [](const std::pair<float, size_t>& a, const std::pair<float, size_t>& b) {
+                return a.first > b.first;
+            });
+            // The selected crops' reads are the same as above, OCR is deterministic
+            for (size_t k = 0; k < std::min(shots, ranked.size()); k++) {
+                const std::string& read = reads[ranked[k].second];
+                best.calls++;
+                if (read == truth) {
+                    best.correct_reads++;
+                }
+                if (!read.empty()) {
+                    best_votes[read]++;
+                }
+            }
+        }
+
+        for (auto* run : {&all, &best}) {
+            const std::map<std::string, int>& votes = run == &all ? all_votes : best_votes;
+            auto leader = std::max_element(votes.begin(), votes.end(),
+                                           [](const std::pair<const std::string, int>& a, const std::pair<const std::string, int>& b) {
+                                               return a.second < b.second;
+                                           });
+            run->tracks++;
+            if (leader != votes.end() && leader->first == truth) {
+                run->correct_tracks++;
+            }
+        }
+    }
+
+    print_selection("every crop", all, crops);
+    print_selection("best-shot ", best, crops);
+    return mismatches == 0 ? 0 : 2;
+}
+
+struct ModelRun {
+    std::vector<std::string> reads;     // first iteration, corpus order
+    size_t correct = 0;
+    std::vector<double> invoke_ms;
+    std::vector<double> total_ms;
+};
+
+ModelRun run_model(const std::string& model_path, const OcrEngineConfig& config,
+                   const std::vector<std::pair<std::string, cv::Mat>>& corpus, int iterations) {
+    ModelRun run;
+    TFOCR ocr;
+    ocr.load_ocr(model_path, "labels.names", config);
+    if (!ocr.loaded()) {
+        return run;
+    }
+
+    for (const auto& crop : corpus) {
+        const cv::Mat& luma = crop.second;
+        ocr.run_ocr_luma(luma.data, static_cast<int>(luma.step), luma.cols, luma.rows, true); // warm-up
+    }
+    for (int it = 0; it < iterations; ++it) {
+        for (const auto& crop : corpus) {
+            const cv::Mat& luma = crop.second;
+            auto start = std::chrono::steady_clock::now();
+            TFOCR::OCRResult read = ocr.run_ocr_luma(luma.data, static_cast<int>(luma.step), luma.cols, luma.rows, true);
+            run.total_ms.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+            run.invoke_ms.push_back(ocr.lastInvokeMs());
+            if (it == 0) {
+                run.correct += read.label == crop.first;
+                run.reads.push_back(read.label);
+            }
+        }
+    }
+    return run;
+}
+
+// --bench ocr-quant <crop_dir> <float.tflite> <quant.tflite> [engine.json] [iterations]
+int bench_ocr_quant(int argc, char* argv[]) {
+    if (argc < 3) {
+        std::cerr << "Usage: --bench ocr-quant <crop_dir> <float.tflite> <quant.tflite> [engine.json] [iterations]" << std::endl;
+        return 1;
+    }
+    OcrEngineConfig config;
+    if (argc > 3 && !load_ocr_engine_config(argv[3], config)) {
+        std::cerr << "Failed to load " << argv[3] << std::endl;
+        return 1;
+    }
+    int iterations = argc > 4 ? std::max(1, atoi(argv[4])) : 5;
+
+    // Same <plate>_<frame> corpus as --bench bestshot
+    std::vector<std::pair<std::string, cv::Mat>> corpus;
+    for (auto& track : load_labelled_crops(argv[0])) {
+        for (LabelledCrop& crop : track.second) {
+            corpus.push_back({track.first, crop.luma});
+        }
+    }
+    std::cout << "[BENCH] ocr-quant: " << corpus.size() << " crops, " << iterations << " iterations, "
+              << describe_ocr_engine_config(config) << std::endl;
+    if (corpus.empty()) {
+        std::cerr << "[BENCH] No <plate>_<frame> crops in " << argv[0] << std::endl;
+        return 1;
+    }
+
+    ModelRun reference = run_model(argv[1], config, corpus, iterations);
+    ModelRun quantized = run_model(argv[2], config, corpus, iterations);
+    if (reference.reads.empty() || quantized.reads.empty()) {
+        return 1;
+    }
+
+    size_t agree = 0;
+    for (size_t i = 0; i < corpus.size(); i++) {
+        agree += reference.reads[i] == quantized.reads[i];
+    }
+    for (auto* run : {&reference, &quantized}) {
+        std::cout << (run == &reference ? argv[1] : argv[2]) << ": accuracy "
+                  << 100.0 * run->correct / corpus.size() << "% (" << run->correct << "/" << corpus.size() << ")" << std::endl;
+        print_latency("invoke", summarize_latency(run->invoke_ms));
+        print_latency("run_ocr", summarize_latency(run->total_ms));
+    }
+    std::cout << "  agreement: " << 100.0 * agree / corpus.size() << "% of reads identical" << std::endl;
+    return 0;
+}
+
+} // namespace
+
+int run_bench(int argc, char* argv[]) {
+    if (argc < 1) {
+        std::cerr << "Usage: --bench parser|ocr|ocr-quant|ctc|bestshot ..." << std::endl;
+        return 1;
+    }
+    if (strcmp(argv[0], "parser") == 0) {
+        return bench_parser(argc - 1, argv + 1);
+    }
+    if (strcmp(argv[0], "ocr") == 0) {
+        return bench_ocr(argc - 1, argv + 1);
+    }
+    if (strcmp(argv[0], "ocr-quant") == 0) {
+        return bench_ocr_quant(argc - 1, argv + 1);
+    }
+    // --bench ctc [time] [classes] [iterations]
+    if (strcmp(argv[0], "ctc") == 0) {
+        return run_ctc_decode_bench(argc > 1 ? atoi(argv[1]) : 48, argc > 2 ? atoi(argv[2]) : 80,
+                                    argc > 3 ? atoi(argv[3]) : 1000);
+    }
+    if (strcmp(argv[0], "bestshot") == 0) {
+        return bench_bestshot(argc - 1, argv + 1);
+    }
+    std::cerr << "Unknown benchmark: " << argv[0] << std::endl;
+    return 1;
+}
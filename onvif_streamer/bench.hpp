@@ -0,0 +1,8 @@
+#ifndef BENCH_HPP
+#define BENCH_HPP
+
+// Offline micro benchmarks, run as `onvif_streamer --bench <name> ...`.
+// Returns the process exit code.
+int run_bench(int argc, char* argv[]);
+
+#endif // BENCH_HPP
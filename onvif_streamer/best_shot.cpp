@@ -0,0 +1,78 @@
+#include "best_shot.hpp"
+
+#include <cmath>
+
+#include "sharpness.hpp"
+
+float best_shot_score(const uint8_t* luma, int stride, int width, int height,
+                      float distance, double distance_scale) {
+    double sharpness = laplacian_variance(luma, stride, width, height);
+    double area = static_cast<double>(width) * height;
+    double proximity = distance_scale > 0.0 ? 1.0 / (1.0 + distance / distance_scale) : 1.0;
+    return static_cast<float>(sharpness * std::sqrt(area) * proximity);
+}
+
+void BestShotSelector::offer(PlateCrop& crop, double now) {
+    offered_++;
+    const AVFrame* frame = crop.frame;
+    Shot shot{crop, best_shot_score(frame->data[0], frame->linesize[0], frame->width, frame->height,
+                                    crop.distance, config_.distance_scale)};
+    crop.frame = nullptr;
+
+    Window& window = windows_[crop.objectId];
+    if (window.shots.empty()) {
+        window.opened = now;
+    }
+
+    // Insert in score order, then drop whatever falls past `shots`
+    size_t pos = window.shots.size();
+    while (pos > 0 && window.shots[pos - 1].score < shot.score) {
+        pos--;
+    }
+    size_t limit = static_cast<size_t>(config_.shots > 0 ? config_.shots : 1);
+    if (pos >= limit) {
+        release_crop_view(shot.crop.frame);
+        return;
+    }
+    window.shots.insert(window.shots.begin() + pos, shot);
+    held_++;
+    if (window.shots.size() > limit) {
+        release_crop_view(window.shots.back().crop.frame);
+        window.shots.pop_back();
+        held_--;
+    }
+}
+
+void BestShotSelector::collect(double now, CropBatch& batch) {
+    for (auto it = windows_.begin(); it != windows_.end();) {
+        Window& window = it->second;
+        // A timeline jump backwards (stream restart) closes the window too
+        if (now - window.opened < config_.window && window.opened <= now) {
+            ++it;
+            continue;
+        }
+        for (Shot& shot : window.shots) {
+            if (batch.pts == AV_NOPTS_VALUE || shot.crop.frame->pts > batch.pts) {
+                batch.pts = shot.crop.frame->pts;
+            }
+            batch.crops.push_back(shot.crop);
+        }
+        selected_ += window.shots.size();
+        held_ -= window.shots.size();
+        it = windows_.erase(it);
+    }
+}
+
+void BestShotSelector::clear() {
+    for (auto& entry : windows_) {
+        for (Shot& shot : entry.second.shots) {
+            release_crop_view(shot.crop.frame);
+        }
+    }
+    windows_.clear();
+    held_ = 0;
+}
+
+BestShotStats BestShotSelector::stats() const {
+    return {offered_.load(), selected_.load(), held_.load()};
+}
@@ -0,0 +1,73 @@
+#ifndef BEST_SHOT_HPP
+#define BEST_SHOT_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "crop.hpp"
+
+struct BestShotConfig {
+    int shots = 1;                  // crops OCRed per object and window
+    double window = 0.25;           // seconds, 0: OCR every crop
+    double distance_scale = 500.0;  // pixels from the reference point that halve a crop's score
+};
+
+struct BestShotStats {
+    uint64_t offered;           // crops scored
+    uint64_t selected;          // crops passed on to OCR
+    size_t held;                // crops waiting for their window to close
+};
+
+// Sharpness * sqrt(area) of a luma plane, discounted by the crop's distance
+// from the reference point
+float best_shot_score(const uint8_t* luma, int stride, int width, int height,
+                      float distance, double distance_scale);
+
+// --- Best-shot selection ---
+// Instead of OCRing every crop, each crop is scored on its Y plane (see
+// best_shot_score) and only the best `shots` crops of an object within a
+// `window` are kept. The window opens with the object's first crop; when
+// it has closed, collect() hands the kept crops over for OCR and the next
+// crop opens a new window. Crops that lose are released immediately, so
+// at most `shots` views per object are held.
+//
+// Single-threaded (the OCR thread); stats() may be called from any thread.
+class BestShotSelector {
+public:
+    ~BestShotSelector() { clear(); }
+
+    void configure(const BestShotConfig& config) { config_ = config; }
+    bool enabled() const { return config_.window > 0.0; }
+
+    // Takes over `crop.frame` (left null) at time `now` (seconds)
+    void offer(PlateCrop& crop, double now);
+    // Append the kept crops of every window closed by `now` to `batch`
+    void collect(double now, CropBatch& batch);
+    // Release everything held
+    void clear();
+
+    BestShotStats stats() const;
+
+private:
+    struct Shot {
+        PlateCrop crop;
+        float score;
+    };
+
+    struct Window {
+        double opened;
+        std::vector<Shot> shots;    // best first
+    };
+
+    BestShotConfig config_;
+    std::unordered_map<int32_t, Window> windows_;
+
+    std::atomic<uint64_t> offered_{0};
+    std::atomic<uint64_t> selected_{0};
+    std::atomic<size_t> held_{0};
+};
+
+#endif // BEST_SHOT_HPP
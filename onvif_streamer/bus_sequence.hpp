@@ -1,6 +0,0 @@
-#define MAX_BUSES 10
-#define MAX_PLATE_LENGTH 24
-
-struct BusSequence {
-    char plates[MAX_BUSES][MAX_PLATE_LENGTH];
-};
\ No newline at end of file
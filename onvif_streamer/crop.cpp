@@ -0,0 +1,64 @@
+#include "crop.hpp"
+
+#include <algorithm>
+
+// Enough frame shells for every crop batch the rings can hold. Globals in
+// main.cpp (cropped_frame_queue, ocrPool, bestShots) release views from
+// their destructors, so the pool is created on first use and never
+// destroyed: whatever the exit order, it is still there for them.
+static FramePool& crop_frame_pool() {
+    static FramePool* pool = new FramePool(64);
+    return *pool;
+}
+
+AVFrame* make_crop_view(const AVFrame* src, int x, int y, int width, int height) {
+    if (!src || width <= 0 || height <= 0) {
+        return nullptr;
+    }
+
+    // Keep the luma origin on even coordinates for 4:2:0 chroma. Rounding
+    // down can push a box at the right or bottom edge one pixel past the
+    // frame, so clip the size afterwards instead of rejecting it.
+    if (x < 0 || y < 0) {
+        return nullptr;
+    }
+    width += x & 1;
+    height += y & 1;
+    x &= ~1;
+    y &= ~1;
+    width = std::min(width, src->width - x);
+    height = std::min(height, src->height - y);
+    if (width <= 0 || height <= 0) {
+        return nullptr;
+    }
+
+    AVFrame* view = crop_frame_pool().acquire();
+    if (!view) {
+        return nullptr;
+    }
+
+    // Share the decoded buffers, then narrow the view with the crop fields
+    if (av_frame_ref(view, src) < 0) {
+        crop_frame_pool().release(view);
+        return nullptr;
+    }
+
+    view->crop_left = x;
+    view->crop_top = y;
+    view->crop_right = src->width - (x + width);
+    view->crop_bottom = src->height - (y + height);
+
+    if (av_frame_apply_cropping(view, AV_FRAME_CROP_UNALIGNED) < 0) {
+        crop_frame_pool().release(view);
+        return nullptr;
+    }
+    return view;
+}
+
+void release_crop_view(AVFrame*& view) {
+    crop_frame_pool().release(view);
+}
+
+PoolStats crop_pool_stats() {
+    return crop_frame_pool().stats();
+}
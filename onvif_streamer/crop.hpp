@@ -0,0 +1,52 @@
+#ifndef CROP_HPP
+#define CROP_HPP
+
+extern "C" {
+#include <libavutil/avutil.h>
+#include <libavutil/frame.h>
+}
+
+#include <cstdint>
+#include <vector>
+
+#include "spsc_ring.hpp"
+#include "frame_pool.hpp"
+
+// A plate crop is a refcounted view into the decoded frame: it shares the
+// frame's buffers and only moves the data pointers, so no pixels are copied
+// and the full frame lives exactly as long as its crops.
+struct PlateCrop {
+    AVFrame* frame;     // view, width/height are the crop size
+    int objectId;       // ONVIF ObjectId of the plate
+    float distance;     // distance from the reference point (crops are sorted by it)
+};
+
+// All crops taken from one decoded frame
+struct CropBatch {
+    int64_t pts = AV_NOPTS_VALUE;
+    std::vector<PlateCrop> crops;
+};
+
+// Returns a pooled frame referencing the (x, y, width, height) region of
+// `src`, or nullptr on failure. The origin is aligned down to even
+// coordinates so 4:2:0 chroma planes stay in step with luma, and the size
+// is clipped to the frame edge.
+AVFrame* make_crop_view(const AVFrame* src, int x, int y, int width, int height);
+// Drop the view's references and return its frame to the pool
+void release_crop_view(AVFrame*& view);
+PoolStats crop_pool_stats();
+
+template<>
+struct RingSlotTraits<CropBatch> {
+    static CropBatch make() { return {}; }
+    static void reset(CropBatch& batch) {
+        for (PlateCrop& crop : batch.crops) {
+            release_crop_view(crop.frame);
+        }
+        batch.crops.clear(); // keep capacity
+        batch.pts = AV_NOPTS_VALUE;
+    }
+    static void dispose(CropBatch&) {}
+};
+
+#endif // CROP_HPP
@@ -0,0 +1,91 @@
+#include "decode_governor.hpp"
+#include <algorithm>
+#include <chrono>
+
+DecodeGovernor::DecodeGovernor() : last_activity_ns_(now_ns()) {
+    configure(DecodeGovernorConfig());
+}
+
+void DecodeGovernor::configure(const DecodeGovernorConfig& config) {
+    config_ = config;
+    idle_timeout_ns_ = static_cast<int64_t>(config.idle_timeout * 1e9);
+    last_activity_ns_.store(now_ns(), std::memory_order_relaxed);
+}
+
+int64_t DecodeGovernor::now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void DecodeGovernor::reportActivity(double pts_seconds) {
+    activity_pts_.store(pts_seconds, std::memory_order_relaxed);
+    last_activity_ns_.store(now_ns(), std::memory_order_relaxed);
+}
+
+bool DecodeGovernor::update() {
+    if (idle_timeout_ns_ <= 0) {
+        return false;
+    }
+
+    int64_t now = now_ns();
+    int64_t last_activity = last_activity_ns_.load(std::memory_order_relaxed);
+
+    if (!idle()) {
+        if (now - last_activity < idle_timeout_ns_) {
+            return false;
+        }
+        idle_.store(true, std::memory_order_relaxed);
+        idle_since_ns_ = now;
+        wake_activity_ns_ = 0;
+        to_idle_.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    if (last_activity <= idle_since_ns_) {
+        return false;
+    }
+    idle_.store(false, std::memory_order_relaxed);
+    wake_activity_ns_ = last_activity;
+    wake_pts_ = activity_pts_.load(std::memory_order_relaxed);
+    to_full_.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+void DecodeGovernor::frameDecoded() {
+    if (wake_activity_ns_ == 0) {
+        return;
+    }
+    double latency_ms = (now_ns() - wake_activity_ns_) / 1e6;
+    wake_activity_ns_ = 0;
+
+    std::lock_guard<std::mutex> lock(latency_mutex_);
+    latency_count_++;
+    latency_sum_ms_ += latency_ms;
+    last_latency_ms_ = latency_ms;
+    max_latency_ms_ = std::max(max_latency_ms_, latency_ms);
+}
+
+void DecodeGovernor::recordCatchUp(double elapsed_ms, size_t packets) {
+    std::lock_guard<std::mutex> lock(latency_mutex_);
+    catchup_count_++;
+    catchup_sum_ms_ += elapsed_ms;
+    last_catchup_ms_ = elapsed_ms;
+    max_catchup_ms_ = std::max(max_catchup_ms_, elapsed_ms);
+    last_catchup_packets_ = packets;
+}
+
+DecodeGovernorStats DecodeGovernor::stats() const {
+    std::lock_guard<std::mutex> lock(latency_mutex_);
+    return {
+        idle(),
+        to_idle_.load(std::memory_order_relaxed),
+        to_full_.load(std::memory_order_relaxed),
+        last_latency_ms_,
+        latency_count_ ? latency_sum_ms_ / latency_count_ : 0.0,
+        max_latency_ms_,
+        last_catchup_ms_,
+        catchup_count_ ? catchup_sum_ms_ / catchup_count_ : 0.0,
+        max_catchup_ms_,
+        last_catchup_packets_
+    };
+}
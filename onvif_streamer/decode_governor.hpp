@@ -0,0 +1,101 @@
+#ifndef DECODE_GOVERNOR_HPP
+#define DECODE_GOVERNOR_HPP
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+}
+
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <mutex>
+
+enum class IdleStrategy {
+    GopBuffer,      // park packets in a GopBuffer, decode nothing
+    Discard         // keep decoding with skip_frame = idle_discard
+};
+
+struct DecodeGovernorConfig {
+    double idle_timeout = 5.0;                   // seconds without plates before going idle, 0: never
+    IdleStrategy idle_strategy = IdleStrategy::GopBuffer;
+    AVDiscard idle_discard = AVDISCARD_NONKEY;   // decoder skip_frame while idle (Discard only)
+};
+
+struct DecodeGovernorStats {
+    bool idle;
+    uint64_t to_idle;
+    uint64_t to_full;
+    double last_latency_ms;     // plate metadata -> first fully decoded frame
+    double avg_latency_ms;
+    double max_latency_ms;
+    double last_catchup_ms;     // decoding the buffered GOP on wake (GopBuffer only)
+    double avg_catchup_ms;
+    double max_catchup_ms;
+    size_t last_catchup_packets;
+};
+
+// --- Activity-adaptive decode ---
+// The metadata thread reports every plate with reportActivity(). When no
+// plate has been seen for idle_timeout seconds the decode thread goes
+// idle: it either stops decoding and buffers the current GOP, or lowers
+// the decoder's skip_frame to idle_discard. The next plate restores full
+// decoding. The switch latency is measured from the metadata that
+// triggered it to the first frame decoded afterwards.
+class DecodeGovernor {
+public:
+    DecodeGovernor();
+    // Call before the decode and metadata threads start
+    void configure(const DecodeGovernorConfig& config);
+
+    // Any thread. `pts_seconds` is the plate's presentation time, if known.
+    void reportActivity(double pts_seconds = NAN);
+
+    // Decode thread, once per packet. Returns true if the mode changed.
+    bool update();
+    // Decode thread, after each decoded frame
+    void frameDecoded();
+    // Decode thread, after decoding the buffered GOP on wake
+    void recordCatchUp(double elapsed_ms, size_t packets);
+
+    // Presentation time (seconds) of the plate that ended the last idle period
+    double wakePts() const { return wake_pts_; }
+
+    bool idle() const { return idle_.load(std::memory_order_relaxed); }
+    // True if leaving idle needs a keyframe, i.e. references were skipped
+    bool resyncOnWake() const {
+        return config_.idle_strategy == IdleStrategy::Discard && config_.idle_discard > AVDISCARD_NONREF;
+    }
+    bool buffersGop() const { return config_.idle_strategy == IdleStrategy::GopBuffer; }
+
+    const DecodeGovernorConfig& config() const { return config_; }
+    DecodeGovernorStats stats() const;
+
+private:
+    static int64_t now_ns();
+
+    DecodeGovernorConfig config_;
+    int64_t idle_timeout_ns_;
+
+    std::atomic<int64_t> last_activity_ns_;
+    std::atomic<double> activity_pts_{NAN};
+    double wake_pts_ = NAN;
+    std::atomic<bool> idle_{false};
+    int64_t idle_since_ns_ = 0;
+    int64_t wake_activity_ns_ = 0;              // pending latency measurement, 0: none
+
+    std::atomic<uint64_t> to_idle_{0};
+    std::atomic<uint64_t> to_full_{0};
+
+    mutable std::mutex latency_mutex_;
+    uint64_t latency_count_ = 0;
+    double latency_sum_ms_ = 0.0;
+    double last_latency_ms_ = 0.0;
+    double max_latency_ms_ = 0.0;
+    uint64_t catchup_count_ = 0;
+    double catchup_sum_ms_ = 0.0;
+    double last_catchup_ms_ = 0.0;
+    double max_catchup_ms_ = 0.0;
+    size_t last_catchup_packets_ = 0;
+};
+
+#endif // DECODE_GOVERNOR_HPP
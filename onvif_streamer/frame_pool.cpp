@@ -0,0 +1,187 @@
+#include "frame_pool.hpp"
+#include <algorithm>
+#include <iostream>
+
+extern "C" {
+#include <libavutil/imgutils.h>
+#include <libavutil/pixdesc.h>
+}
+
+FramePool::FramePool(size_t capacity) : capacity_(capacity) {
+    free_.reserve(capacity_);
+    for (size_t i = 0; i < capacity_; ++i) {
+        AVFrame* frame = av_frame_alloc();
+        if (frame) {
+            free_.push_back(frame);
+            allocations_++;
+        }
+    }
+}
+
+FramePool::~FramePool() {
+    for (AVFrame*& frame : free_) {
+        av_frame_free(&frame);
+    }
+}
+
+AVFrame* FramePool::acquire() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    acquired_++;
+    if (!free_.empty()) {
+        AVFrame* frame = free_.back();
+        free_.pop_back();
+        in_use_++;
+        peak_in_use_ = std::max(peak_in_use_, in_use_);
+        return frame;
+    }
+    allocations_++;
+    lock.unlock();
+
+    AVFrame* frame = av_frame_alloc();
+    if (frame) {
+        lock.lock();
+        in_use_++;
+        peak_in_use_ = std::max(peak_in_use_, in_use_);
+    }
+    return frame;
+}
+
+void FramePool::release(AVFrame*& frame) {
+    if (!frame) {
+        return;
+    }
+    av_frame_unref(frame); // drops the buffer references outside the lock
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    in_use_--;
+    if (free_.size() < capacity_) {
+        free_.push_back(frame);
+        frame = nullptr;
+        return;
+    }
+    lock.unlock();
+    av_frame_free(&frame);
+}
+
+PoolStats FramePool::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return {capacity_, in_use_, peak_in_use_, acquired_, allocations_};
+}
+
+DecoderBufferPool::~DecoderBufferPool() {
+    releasePools();
+}
+
+void DecoderBufferPool::attach(AVCodecContext* ctx) {
+    if (!(ctx->codec && (ctx->codec->capabilities & AV_CODEC_CAP_DR1))) {
+        std::cout << "[POOL] Decoder does not support custom buffers, using default allocator" << std::endl;
+        return;
+    }
+    ctx->opaque = this;
+    ctx->get_buffer2 = &DecoderBufferPool::getBuffer;
+#if FF_API_THREAD_SAFE_CALLBACKS
+    // Let frame threads allocate directly instead of through the main thread
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wdeprecated-declarations"
+    ctx->thread_safe_callbacks = 1;
+#pragma GCC diagnostic pop
+#endif
+}
+
+#if LIBAVUTIL_VERSION_MAJOR >= 57
+AVBufferRef* DecoderBufferPool::allocBuffer(void* opaque, size_t size) {
+#else
+AVBufferRef* DecoderBufferPool::allocBuffer(void* opaque, int size) {
+#endif
+    auto* self = static_cast<DecoderBufferPool*>(opaque);
+    AVBufferRef* buf = av_buffer_alloc(size);
+    if (buf) {
+        self->allocations_.fetch_add(1, std::memory_order_relaxed);
+        self->allocated_bytes_.fetch_add(size, std::memory_order_relaxed);
+    }
+    return buf;
+}
+
+int DecoderBufferPool::getBuffer(AVCodecContext* ctx, AVFrame* frame, int flags) {
+    auto* self = static_cast<DecoderBufferPool*>(ctx->opaque);
+    if (frame->format != AV_PIX_FMT_YUV420P && frame->format != AV_PIX_FMT_YUVJ420P) {
+        return avcodec_default_get_buffer2(ctx, frame, flags);
+    }
+
+    std::lock_guard<std::mutex> lock(self->mutex_);
+    if (!self->configure(ctx, frame)) {
+        return AVERROR(ENOMEM);
+    }
+
+    for (int i = 0; i < PLANES; ++i) {
+        frame->buf[i] = av_buffer_pool_get(self->pools_[i]);
+        if (!frame->buf[i]) {
+            for (int j = 0; j < i; ++j) {
+                av_buffer_unref(&frame->buf[j]);
+            }
+            return AVERROR(ENOMEM);
+        }
+        frame->data[i] = frame->buf[i]->data;
+        frame->linesize[i] = self->linesize_[i];
+    }
+    frame->extended_data = frame->data;
+    self->acquired_.fetch_add(PLANES, std::memory_order_relaxed);
+    return 0;
+}
+
+// (Re)build the per-plane pools for the frame's geometry. Plane layout
+// follows avcodec_default_get_buffer2: dimensions aligned for the codec,
+// line sizes aligned for SIMD, and some tail padding for overreads.
+bool DecoderBufferPool::configure(AVCodecContext* ctx, const AVFrame* frame) {
+    if (pools_[0] && frame->format == format_ && frame->width == width_ && frame->height == height_) {
+        return true;
+    }
+    releasePools();
+
+    const int align = 64;
+    int w = frame->width;
+    int h = frame->height;
+    int linesize_align[AV_NUM_DATA_POINTERS];
+    avcodec_align_dimensions2(ctx, &w, &h, linesize_align);
+
+    int linesizes[4] = {0, 0, 0, 0};
+    if (av_image_fill_linesizes(linesizes, static_cast<AVPixelFormat>(frame->format), FFALIGN(w, align)) < 0) {
+        return false;
+    }
+
+    const AVPixFmtDescriptor* desc = av_pix_fmt_desc_get(static_cast<AVPixelFormat>(frame->format));
+    for (int i = 0; i < PLANES; ++i) {
+        linesize_[i] = FFALIGN(linesizes[i], align);
+        int plane_height = i == 0 ? h : AV_CEIL_RSHIFT(h, desc->log2_chroma_h);
+        size_t size = static_cast<size_t>(linesize_[i]) * plane_height + 16 + align - 1;
+        pools_[i] = av_buffer_pool_init2(size, this, &DecoderBufferPool::allocBuffer, nullptr);
+        if (!pools_[i]) {
+            releasePools();
+            return false;
+        }
+    }
+
+    format_ = frame->format;
+    width_ = frame->width;
+    height_ = frame->height;
+    std::cout << "[POOL] Decoder buffer pools for " << width_ << "x" << height_
+              << " " << av_get_pix_fmt_name(static_cast<AVPixelFormat>(format_)) << std::endl;
+    return true;
+}
+
+void DecoderBufferPool::releasePools() {
+    // Buffers still referenced by frames stay valid; each pool is freed
+    // once its last buffer comes back
+    for (auto& pool : pools_) {
+        av_buffer_pool_uninit(&pool);
+    }
+    format_ = -1;
+}
+
+BufferPoolStats DecoderBufferPool::stats() const {
+    return {
+        acquired_.load(std::memory_order_relaxed),
+        allocations_.load(std::memory_order_relaxed),
+        allocated_bytes_.load(std::memory_order_relaxed)
+    };
+}
@@ -0,0 +1,104 @@
+#ifndef FRAME_POOL_HPP
+#define FRAME_POOL_HPP
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavutil/buffer.h>
+#include <libavutil/frame.h>
+}
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+struct PoolStats {
+    size_t capacity;        // items kept for reuse
+    size_t in_use;
+    size_t peak_in_use;
+    uint64_t acquired;
+    uint64_t allocations;   // heap allocations; flat in steady state
+};
+
+struct BufferPoolStats {
+    uint64_t acquired;      // plane buffers handed to the decoder
+    uint64_t allocations;   // of which newly allocated; flat in steady state
+    size_t allocated_bytes;
+};
+
+// --- Recycled AVFrame shells ---
+// Frame structs for short-lived references (crop views) come from a free
+// list instead of av_frame_alloc(). Frames may be released on any thread.
+// When the pool runs dry it allocates and counts it, and frames beyond the
+// capacity are freed on release.
+class FramePool {
+public:
+    explicit FramePool(size_t capacity);
+    ~FramePool();
+
+    FramePool(const FramePool&) = delete;
+    FramePool& operator=(const FramePool&) = delete;
+
+    // Blank frame, or nullptr if allocation failed
+    AVFrame* acquire();
+    // Unrefs the frame and returns it to the pool; `frame` is set to nullptr
+    void release(AVFrame*& frame);
+
+    PoolStats stats() const;
+
+private:
+    const size_t capacity_;
+    mutable std::mutex mutex_;
+    std::vector<AVFrame*> free_;
+    size_t in_use_ = 0;
+    size_t peak_in_use_ = 0;
+    uint64_t acquired_ = 0;
+    uint64_t allocations_ = 0;
+};
+
+// --- Pooled decoder output buffers ---
+// Installed as the decoder's get_buffer2 callback: YUV 4:2:0 planes come
+// from one AVBufferPool per plane, sized for the stream and rebuilt only
+// when the resolution or format changes. Decoded frames (and every crop
+// view referencing them) hand their buffers back to the pool when the
+// last reference is dropped. Other formats use the default allocator.
+class DecoderBufferPool {
+public:
+    DecoderBufferPool() = default;
+    ~DecoderBufferPool();
+
+    DecoderBufferPool(const DecoderBufferPool&) = delete;
+    DecoderBufferPool& operator=(const DecoderBufferPool&) = delete;
+
+    // Call before avcodec_open2()
+    void attach(AVCodecContext* ctx);
+
+    BufferPoolStats stats() const;
+
+private:
+    static constexpr int PLANES = 3;
+
+    static int getBuffer(AVCodecContext* ctx, AVFrame* frame, int flags);
+#if LIBAVUTIL_VERSION_MAJOR >= 57
+    static AVBufferRef* allocBuffer(void* opaque, size_t size);
+#else
+    static AVBufferRef* allocBuffer(void* opaque, int size);
+#endif
+
+    bool configure(AVCodecContext* ctx, const AVFrame* frame);
+    void releasePools();
+
+    std::mutex mutex_;   // frame threads call get_buffer2 concurrently
+    AVBufferPool* pools_[PLANES] = {nullptr, nullptr, nullptr};
+    int format_ = -1;
+    int width_ = 0;
+    int height_ = 0;
+    int linesize_[PLANES] = {0, 0, 0};
+
+    std::atomic<uint64_t> acquired_{0};
+    std::atomic<uint64_t> allocations_{0};
+    std::atomic<size_t> allocated_bytes_{0};
+};
+
+#endif // FRAME_POOL_HPP
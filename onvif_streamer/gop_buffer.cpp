@@ -0,0 +1,74 @@
+#include "gop_buffer.hpp"
+#include <algorithm>
+
+GopBuffer::GopBuffer(const GopBufferConfig& config) : config_(config) {
+    slots_.resize(std::max<size_t>(config_.max_packets, 1));
+    for (auto& slot : slots_) {
+        slot = av_packet_alloc();
+    }
+}
+
+GopBuffer::~GopBuffer() {
+    for (auto& slot : slots_) {
+        av_packet_free(&slot);
+    }
+}
+
+bool GopBuffer::push(AVPacket* pkt) {
+    if (pkt->flags & AV_PKT_FLAG_KEY) {
+        clear();
+        overflowed_ = false;
+    } else if (count_ == 0 || overflowed_) {
+        av_packet_unref(pkt); // nothing to decode it against
+        return false;
+    }
+
+    if (count_ == slots_.size() || bytes_ + pkt->size > config_.max_bytes) {
+        // The GOP is unusable without all of its packets
+        clear();
+        overflowed_ = true;
+        overflows_.fetch_add(1, std::memory_order_relaxed);
+        av_packet_unref(pkt);
+        return false;
+    }
+
+    av_packet_move_ref(slots_[count_++], pkt);
+    bytes_ += slots_[count_ - 1]->size;
+    publish();
+    return true;
+}
+
+void GopBuffer::clear() {
+    for (size_t i = 0; i < count_; ++i) {
+        av_packet_unref(slots_[i]);
+    }
+    count_ = 0;
+    bytes_ = 0;
+    publish();
+}
+
+void GopBuffer::discardUntilKeyframe() {
+    clear();
+    overflowed_ = true;
+}
+
+void GopBuffer::publish() {
+    published_packets_.store(count_, std::memory_order_relaxed);
+    published_bytes_.store(bytes_, std::memory_order_relaxed);
+    if (count_ > peak_packets_.load(std::memory_order_relaxed)) {
+        peak_packets_.store(count_, std::memory_order_relaxed);
+    }
+    if (bytes_ > peak_bytes_.load(std::memory_order_relaxed)) {
+        peak_bytes_.store(bytes_, std::memory_order_relaxed);
+    }
+}
+
+GopBufferStats GopBuffer::stats() const {
+    return {
+        published_packets_.load(std::memory_order_relaxed),
+        published_bytes_.load(std::memory_order_relaxed),
+        peak_packets_.load(std::memory_order_relaxed),
+        peak_bytes_.load(std::memory_order_relaxed),
+        overflows_.load(std::memory_order_relaxed)
+    };
+}
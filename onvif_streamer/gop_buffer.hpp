@@ -0,0 +1,75 @@
+#ifndef GOP_BUFFER_HPP
+#define GOP_BUFFER_HPP
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+}
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct GopBufferConfig {
+    size_t max_packets = 250;               // 10 s at 25 fps
+    size_t max_bytes = 32 * 1024 * 1024;
+};
+
+struct GopBufferStats {
+    size_t packets;
+    size_t bytes;
+    size_t peak_packets;
+    size_t peak_bytes;
+    uint64_t overflows;     // GOPs abandoned because a limit was hit
+};
+
+// --- Compressed packets since the last keyframe ---
+// While the decoder is idle every video packet is parked here instead of
+// being decoded. A keyframe starts a new GOP and releases the previous
+// one, so the buffer always holds exactly what is needed to decode the
+// newest frame. Packet slots are allocated once; payloads are moved in by
+// reference, never copied.
+class GopBuffer {
+public:
+    explicit GopBuffer(const GopBufferConfig& config = GopBufferConfig());
+    ~GopBuffer();
+
+    GopBuffer(const GopBuffer&) = delete;
+    GopBuffer& operator=(const GopBuffer&) = delete;
+
+    // Takes the reference held by `pkt` (left empty). Returns false if the
+    // packet was discarded: no keyframe yet, or the GOP outgrew the limits.
+    bool push(AVPacket* pkt);
+
+    size_t size() const { return count_; }
+    bool empty() const { return count_ == 0; }
+    // i-th packet of the GOP, starting with the keyframe
+    AVPacket* at(size_t i) const { return slots_[i]; }
+
+    // Release all payloads; slots stay allocated
+    void clear();
+    // The reference chain broke upstream: drop the GOP and wait for a keyframe
+    void discardUntilKeyframe();
+
+    // Reads the counters publish() leaves in relaxed atomics, no lock; may
+    // be called from any thread while the owner pushes
+    GopBufferStats stats() const;
+
+private:
+    GopBufferConfig config_;
+    std::vector<AVPacket*> slots_;
+    size_t count_ = 0;
+    size_t bytes_ = 0;
+    bool overflowed_ = false;   // skip until the next keyframe
+
+    // Published for stats()
+    std::atomic<size_t> published_packets_{0};
+    std::atomic<size_t> published_bytes_{0};
+    std::atomic<size_t> peak_packets_{0};
+    std::atomic<size_t> peak_bytes_{0};
+    std::atomic<uint64_t> overflows_{0};
+
+    void publish();
+};
+
+#endif // GOP_BUFFER_HPP
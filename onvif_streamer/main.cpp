@@ -4,16 +4,16 @@ extern "C" {
 #include <libavutil/error.h>
 #include <libavutil/time.h>
 #include <libavutil/rational.h>
-#include <libswscale/swscale.h>
 #include <libavutil/imgutils.h>
 }
-#include <tinyxml2.h>
 #include <iostream>
 #include <vector>
 #include <chrono>
 #include <unistd.h>
 #include <mutex>
 #include <string>
+#include <cstring>
+#include <cstdlib>
 #include <deque>
 #include <thread>
 #include <atomic>
@@ -30,74 +30,116 @@ extern "C" {
 #include "parser.hpp"
 #include "video.hpp"
 #include "ocr.hpp"
+#include "ocr_pool.hpp"
+#include "plate_tracker.hpp"
+#include "best_shot.hpp"
 #include "bus_sequence.hpp"
-#include "json.hpp"
+#include "spsc_ring.hpp"
+#include "event_notifier.hpp"
+#include "crop.hpp"
+#include "metadata_index.hpp"
+#include "decode_governor.hpp"
+#include "gop_buffer.hpp"
+#include "bench.hpp"
+#include "ocr_engine.hpp"
+#include "debug_recorder.hpp"
 #include <sys/mman.h>
 #include <fcntl.h>
 
 #define HANWHA_ORIGINAL_WIDTH 3840.0
 #define HANWHA_ORIGINAL_HEIGHT 2160.0
 
-using json = nlohmann::ordered_json;
 
-// --- Thread-Safe Queue ---
-template<typename T>
-class ThreadSafeQueue {
-public:
-    void push(T value) {
-        std::unique_lock<std::mutex> lock(mutex_);
-        queue_.push(std::move(value));
-        cond_.notify_one();
-    }
-
-    bool try_pop(T& value) {
-        std::unique_lock<std::mutex> lock(mutex_);
-        if (queue_.empty()) {
-            return false;
-        }
-        value = std::move(queue_.front());
-        queue_.pop();
-        return true;
-    }
-
-    T wait_and_pop() {
-        std::unique_lock<std::mutex> lock(mutex_);
-        cond_.wait(lock, [this] { return !queue_.empty(); });
-        T value = std::move(queue_.front());
-        queue_.pop();
-        return value;
-    }
-
-    bool empty() const {
-        std::unique_lock<std::mutex> lock(mutex_);
-        return queue_.empty();
-    }
+// --- Ring slot recycling for FFmpeg handles ---
+// Packets and frames are allocated once per ring slot and moved between
+// threads by swapping pointers, so the hot path never clones.
+template<>
+struct RingSlotTraits<AVPacket*> {
+    static AVPacket* make() { return av_packet_alloc(); }
+    static void reset(AVPacket*& pkt) { av_packet_unref(pkt); }
+    static void dispose(AVPacket*& pkt) { av_packet_free(&pkt); }
+};
 
-private:
-    std::queue<T> queue_;
-    mutable std::mutex mutex_;
-    std::condition_variable cond_;
+template<>
+struct RingSlotTraits<AVFrame*> {
+    static AVFrame* make() { return av_frame_alloc(); }
+    static void reset(AVFrame*& frame) { av_frame_unref(frame); }
+    static void dispose(AVFrame*& frame) { av_frame_free(&frame); }
 };
 
 // --- Global Variables ---
 MetadataParser metadataParser;
 VideoProcessor videoProcessor;
-TFOCR ocrProcessor;
+OcrWorkerPool ocrPool;
+size_t ocr_workers = 2; // --ocr-workers
+
+// Per-ObjectId OCR cache, see --ocr-votes / --ocr-vote-confidence / --track-expiry
+PlateTrackerConfig plate_tracker_config;
+PlateTracker plateTracker; // OCR thread only, except stats()
+
+// Only the best crops of each object are OCRed, see --best-shots / --best-shot-window
+BestShotConfig best_shot_config;
+BestShotSelector bestShots; // OCR thread only, except stats()
 
 // Queues for packets from stream
-ThreadSafeQueue<AVPacket*> video_packet_queue;
-ThreadSafeQueue<AVPacket*> metadata_packet_queue;
+// Compressed video must not be dropped silently (it breaks the reference
+// chain), so the reader blocks briefly and the decoder resyncs on a keyframe
+// if a packet is dropped anyway.
+SpscRing<AVPacket*> video_packet_queue(64, OverflowPolicy::BlockWithTimeout, std::chrono::milliseconds(100));
+SpscRing<AVPacket*> metadata_packet_queue(64, OverflowPolicy::DropOldest);
 
 // Queues for decoded data
-ThreadSafeQueue<AVFrame*> frame_queue;
-ThreadSafeQueue<MetadataResult> metadata_queue;
+SpscRing<AVFrame*> frame_queue(4, OverflowPolicy::DropOldest);
+SpscRing<MetadataResult> metadata_queue(32, OverflowPolicy::DropOldest);
+
+// Frames for the optional SDL display sink
+SpscRing<AVFrame*> display_queue(2, OverflowPolicy::DropOldest);
 
-// Queue for cropped frames
-ThreadSafeQueue< std::vector<AVFrame*> > cropped_frame_queue;
+// Queue for cropped frames (zero-copy views into decoded frames)
+SpscRing<CropBatch> cropped_frame_queue(8, OverflowPolicy::DropOldest);
 
 // Atomics for thread control
 std::atomic<bool> run_threads{true};
 
+// SDL display sink; disabled with --headless
+bool display_enabled = true;
+
+// OCR execution backend, from ocr_engine.json or --ocr-config
+std::string ocr_engine_config_path = "ocr_engine.json";
+OcrEngineConfig ocr_engine_config;
+
+// Sampled debug images, from debug_recorder.json or --debug-config (off without it)
+std::string debug_config_path = "debug_recorder.json";
+
+// Frame/metadata matching, --match-tolerance overrides the tolerance (seconds)
+MetadataIndexConfig metadata_index_config;
+
+// Skip decoding while no plates are around, see --idle-timeout / --idle-mode / --idle-discard
+DecodeGovernorConfig decode_governor_config;
+DecodeGovernor decodeGovernor;
+GopBuffer gopBuffer; // packets since the last keyframe while idle (decode thread only)
+
+// Per-consumer wakeups, signalled by the rings feeding each thread
+EventNotifier decode_wakeup;
+EventNotifier metadata_wakeup;
+EventNotifier sync_wakeup;
+EventNotifier render_wakeup;
+EventNotifier ocr_wakeup;
+EventNotifier stats_wakeup;
+
+// Upper bound on a single sleep, so run_threads is rechecked even without traffic
+const std::chrono::milliseconds WAKEUP_TIMEOUT(100);
+
+void stop_threads() {
+    run_threads = false;
+    decode_wakeup.notify();
+    metadata_wakeup.notify();
+    sync_wakeup.notify();
+    render_wakeup.notify();
+    ocr_wakeup.notify();
+    stats_wakeup.notify();
+}
+
 // Clock sync variables (similar to ffplay)
 struct Clock {
     double pts;
@@ -112,141 +154,163 @@ Clock master_clock = {0.0, 0.0, 1.0, 0, false};
 
 // --- Thread Functions ---
 void stream_thread(AVFormatContext* formatContext, int data_stream_index, int video_stream_index) {
-    AVPacket pkt;
-    av_init_packet(&pkt);
+    AVPacket* pkt = av_packet_alloc();
 
     while(run_threads) {
-        if (av_read_frame(formatContext, &pkt) >= 0) {
-            AVPacket *cloned_pkt = av_packet_clone(&pkt);
-            if (pkt.stream_index == video_stream_index) {
-                video_packet_queue.push(cloned_pkt);
-            } else if (pkt.stream_index == data_stream_index) {
-                metadata_packet_queue.push(cloned_pkt);
+        if (av_read_frame(formatContext, pkt) >= 0) {
+            if (pkt->stream_index == video_stream_index) {
+                video_packet_queue.push(pkt);
+            } else if (pkt->stream_index == data_stream_index) {
+                metadata_packet_queue.push(pkt);
             } else {
-                av_packet_free(&cloned_pkt); // Not a stream we are interested in
+                av_packet_unref(pkt); // Not a stream we are interested in
             }
-            av_packet_unref(&pkt);
         } else {
-            run_threads = false; // End of stream or error
+            stop_threads(); // End of stream or error
             break;
         }
     }
+    av_packet_free(&pkt);
     std::cout << "Stream thread finished." << std::endl;
 }
 
-void decode_thread(AVFormatContext* formatContext, int video_stream_index) {
-    // Initialize VideoProcessor
-    if (!videoProcessor.initialize(formatContext->streams[video_stream_index]->codecpar)) {
-        std::cerr << "Failed to initialize VideoProcessor" << std::endl;
-        run_threads = false;
-        return;
-    }
+// Decode the GOP parked while idle, from its keyframe up to the plate that
+// woke the decoder. Frames before the plate are decoded as references only.
+void catch_up_gop(AVFrame* frame, AVRational time_base) {
+    auto start = std::chrono::steady_clock::now();
+    size_t packets = gopBuffer.size();
 
-    // Video Codec Setup (for additional processing if needed)
-    AVCodecParameters* vid_codecpar = formatContext->streams[video_stream_index]->codecpar;
-    AVCodec* codec = avcodec_find_decoder(vid_codecpar->codec_id);
-    if (!codec) {
-        std::cerr << "Unsupported video codec!" << std::endl;
-        run_threads = false;
-        return;
-    }
-    
-    AVCodecContext* codec_context = avcodec_alloc_context3(codec);
-    if (avcodec_parameters_to_context(codec_context, vid_codecpar) < 0) {
-        avcodec_free_context(&codec_context);
-        std::cerr << "Could not copy codec parameters to context" << std::endl;
-        run_threads = false;
-        return;
+    // Decoder state is stale; restart from the buffered keyframe
+    videoProcessor.flush();
+    double first_pts = decodeGovernor.wakePts() - metadata_index_config.match_tolerance;
+
+    for (size_t i = 0; i < packets; ++i) {
+        if (!videoProcessor.sendPacket(gopBuffer.at(i))) {
+            continue;
+        }
+        while (videoProcessor.receiveFrame(frame)) {
+            if (frame->pts != AV_NOPTS_VALUE && frame->pts * av_q2d(time_base) < first_pts) {
+                av_frame_unref(frame);
+                continue;
+            }
+            decodeGovernor.frameDecoded();
+            frame_queue.push(frame);
+        }
     }
-    
-    // Enhanced decoding configuration for I/P frame reference handling
-    codec_context->thread_count = 0;
-    codec_context->thread_type = FF_THREAD_FRAME | FF_THREAD_SLICE;
-    codec_context->error_concealment = FF_EC_GUESS_MVS | FF_EC_DEBLOCK;
-    codec_context->err_recognition = AV_EF_CRCCHECK | AV_EF_BITSTREAM | AV_EF_BUFFER;
-    codec_context->skip_frame = AVDISCARD_NONE;
-    codec_context->flags |= AV_CODEC_FLAG_OUTPUT_CORRUPT;
-    
-    if (avcodec_open2(codec_context, codec, nullptr) < 0) {
-        avcodec_free_context(&codec_context);
-        std::cerr << "Could not open codec" << std::endl;
-        run_threads = false;
+    gopBuffer.clear();
+
+    double elapsed_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    decodeGovernor.recordCatchUp(elapsed_ms, packets);
+    std::cout << "[VIDEO] Caught up " << packets << " buffered packets in " << elapsed_ms << " ms" << std::endl;
+}
+
+void decode_thread(AVFormatContext* formatContext, int video_stream_index) {
+    // VideoProcessor is the only decoder instance in the pipeline
+    DecoderConfig decoder_config;
+    if (!videoProcessor.initialize(formatContext->streams[video_stream_index]->codecpar, decoder_config)) {
+        std::cerr << "Failed to initialize VideoProcessor" << std::endl;
+        stop_threads();
         return;
     }
 
     AVFrame* frame = av_frame_alloc();
     if (!frame) {
         std::cerr << "Could not allocate frame" << std::endl;
-        run_threads = false;
-        avcodec_close(codec_context);
-        avcodec_free_context(&codec_context);
+        stop_threads();
         return;
     }
 
-    // Frame reference tracking for I/P frame handling
-    bool need_keyframe = true;
-    int consecutive_errors = 0;
-    const int MAX_CONSECUTIVE_ERRORS = 10;
+    AVRational time_base = formatContext->streams[video_stream_index]->time_base;
+    uint64_t seen_packet_drops = 0;
+    AVPacket* pkt = av_packet_alloc();
 
     while (run_threads) {
         // Decode Video Packets
-        AVPacket* pkt = nullptr;
-        if (video_packet_queue.try_pop(pkt)) {
-            // I/P frame reference handling
-            if (need_keyframe && !(pkt->flags & AV_PKT_FLAG_KEY)) {
-                std::cout << "[DECODE] Waiting for keyframe, dropping P-frame" << std::endl;
-                av_packet_free(&pkt);
-                continue;
-            }
-            
-            int ret = avcodec_send_packet(codec_context, pkt);
-            if (ret < 0) {
-                consecutive_errors++;
-                if (consecutive_errors > MAX_CONSECUTIVE_ERRORS) {
-                    std::cerr << "[DECODE] Too many consecutive errors, flushing decoder" << std::endl;
-                    avcodec_flush_buffers(codec_context);
-                    need_keyframe = true;
-                    consecutive_errors = 0;
+        uint64_t wake_key = decode_wakeup.prepare_wait();
+        if (!video_packet_queue.try_pop(pkt)) {
+            decode_wakeup.wait(wake_key, WAKEUP_TIMEOUT);
+            continue;
+        }
+
+        // A dropped packet breaks the reference chain, resync on the next keyframe
+        uint64_t packet_drops = video_packet_queue.drops();
+        if (packet_drops != seen_packet_drops) {
+            seen_packet_drops = packet_drops;
+            videoProcessor.requestKeyframe();
+            gopBuffer.discardUntilKeyframe();
+        }
+
+        if (decodeGovernor.update()) {
+            if (decodeGovernor.idle()) {
+                if (!decodeGovernor.buffersGop()) {
+                    videoProcessor.setSkipFrame(decode_governor_config.idle_discard);
                 }
-                av_packet_free(&pkt);
-                continue;
-            }
-            
-            while (avcodec_receive_frame(codec_context, frame) == 0) {
-                AVFrame* cloned_frame = av_frame_clone(frame);
-                if (cloned_frame) {
-                    frame_queue.push(cloned_frame);
-                    need_keyframe = false;
-                    consecutive_errors = 0;
+                std::cout << "[VIDEO] No plates, decoder idle" << std::endl;
+            } else {
+                std::cout << "[VIDEO] Plate detected, full decode" << std::endl;
+                if (decodeGovernor.buffersGop()) {
+                    catch_up_gop(frame, time_base);
+                } else {
+                    videoProcessor.setSkipFrame(AVDISCARD_NONE);
+                    if (decodeGovernor.resyncOnWake()) {
+                        videoProcessor.requestKeyframe(); // skipped frames are missing as references
+                    }
                 }
             }
-            av_packet_free(&pkt);
         }
 
-        // Parse Metadata Packets
-        AVPacket* meta_pkt = nullptr;
-        if (metadata_packet_queue.try_pop(meta_pkt)) {
-            metadataParser.processPacket(meta_pkt);
-            
-            // Get completed metadata results
-            std::vector<MetadataResult> results = metadataParser.getCompletedResults();
-            for (const auto& result : results) {
-                metadata_queue.push(result);
-            }
-            
-            av_packet_free(&meta_pkt);
+        if (decodeGovernor.idle() && decodeGovernor.buffersGop()) {
+            gopBuffer.push(pkt); // decoded later, only if a plate shows up
+            continue;
+        }
+
+        if (!videoProcessor.sendPacket(pkt)) {
+            continue;
+        }
+
+        while (videoProcessor.receiveFrame(frame)) {
+            decodeGovernor.frameDecoded();
+            // Hand the frame to the ring; `frame` comes back as an empty recycled slot
+            frame_queue.push(frame);
         }
-        
-        // Small delay to prevent busy waiting
-        std::this_thread::sleep_for(std::chrono::microseconds(100));
     }
 
+    av_packet_free(&pkt);
     av_frame_free(&frame);
-    avcodec_close(codec_context);
-    avcodec_free_context(&codec_context);
     std::cout << "Decode thread finished." << std::endl;
 }
 
+// Metadata parsing runs on its own thread so XML work never delays video decode
+void metadata_thread(AVRational time_base) {
+    AVPacket* meta_pkt = av_packet_alloc();
+    MetadataResult result = RingSlotTraits<MetadataResult>::make(); // recycled
+
+    while (run_threads) {
+        uint64_t wake_key = metadata_wakeup.prepare_wait();
+        if (!metadata_packet_queue.try_pop(meta_pkt)) {
+            metadata_wakeup.wait(wake_key, WAKEUP_TIMEOUT);
+            continue;
+        }
+
+        metadataParser.processPacket(meta_pkt);
+
+        // Get completed metadata results
+        bool plates = false;
+        int64_t plate_pts = AV_NOPTS_VALUE;
+        while (metadataParser.popCompletedResult(result)) {
+            plates = true; // the parser only reports plates
+            plate_pts = result.pts;
+            metadata_queue.push(result);
+        }
+        if (plates) {
+            decodeGovernor.reportActivity(plate_pts != AV_NOPTS_VALUE ? plate_pts * av_q2d(time_base) : NAN);
+        }
+    }
+
+    av_packet_free(&meta_pkt);
+    std::cout << "Metadata thread finished." << std::endl;
+}
+
 // Helper functions for clock synchronization
 double get_clock(Clock* c) {
     if (c->paused) {
@@ -321,11 +385,11 @@ void render_metadata_overlay(SDL_Renderer* renderer, const MetadataResult& metad
     }
 }
 
-std::vector<AVFrame*> render_metadata_crop_to_avframe(AVFrame* frame, const MetadataResult& metadata, int width, int height, cv::Point2f reference_point = cv::Point2f(-1, -1)) {
-    std::vector<AVFrame*> cropped_frames;
+void crop_metadata_objects(AVFrame* frame, const MetadataResult& metadata, int width, int height, CropBatch& batch, cv::Point2f reference_point = cv::Point2f(-1, -1)) {
+    batch.pts = frame ? frame->pts : AV_NOPTS_VALUE;
     
     if (metadata.objects.empty() || !frame) {
-        return cropped_frames;
+        return;
     }
     
     // If reference point is not provided, use center of screen as default
@@ -333,14 +397,6 @@ std::vector<AVFrame*> render_metadata_crop_to_avframe(AVFrame* frame, const Meta
         reference_point = cv::Point2f(width / 2.0f, height / 2.0f);
     }
     
-    // Structure to hold cropped frame and its distance
-    struct CroppedFrameWithDistance {
-        AVFrame* frame;
-        float distance;
-    };
-    
-    std::vector<CroppedFrameWithDistance> frames_with_distance;
-    
     for (const auto& obj : metadata.objects) {
         // Convert normalized coordinates to pixel coordinates
         int x1 = static_cast<int>((obj.boundingBox.left / HANWHA_ORIGINAL_WIDTH) * width);
@@ -366,57 +422,12 @@ std::vector<AVFrame*> render_metadata_crop_to_avframe(AVFrame* frame, const Meta
         int crop_height = y2 - y1;
         
         if (crop_width > 0 && crop_height > 0) {
-            // Create new AVFrame for cropped region
-            AVFrame* cropped_frame = av_frame_alloc();
+            // Zero-copy view into the decoded frame
+            AVFrame* cropped_frame = make_crop_view(frame, x1, y1, crop_width, crop_height);
             if (!cropped_frame) {
                 continue;
             }
             
-            cropped_frame->format = frame->format;
-            cropped_frame->width = crop_width;
-            cropped_frame->height = crop_height;
-            
-            if (av_frame_get_buffer(cropped_frame, 32) < 0) {
-                av_frame_free(&cropped_frame);
-                continue;
-            }
-            
-            // Copy YUV420P data manually
-            // Y plane
-            for (int y = 0; y < crop_height; y++) {
-                int src_y = y1 + y;
-                if (src_y < height) {
-                    uint8_t* src_line = frame->data[0] + src_y * frame->linesize[0] + x1;
-                    uint8_t* dst_line = cropped_frame->data[0] + y * cropped_frame->linesize[0];
-                    memcpy(dst_line, src_line, crop_width);
-                }
-            }
-            
-            // U plane (half resolution)
-            int uv_crop_width = crop_width / 2;
-            int uv_crop_height = crop_height / 2;
-            int uv_x1 = x1 / 2;
-            int uv_y1 = y1 / 2;
-            
-            for (int y = 0; y < uv_crop_height; y++) {
-                int src_y = uv_y1 + y;
-                if (src_y < height / 2) {
-                    uint8_t* src_line = frame->data[1] + src_y * frame->linesize[1] + uv_x1;
-                    uint8_t* dst_line = cropped_frame->data[1] + y * cropped_frame->linesize[1];
-                    memcpy(dst_line, src_line, uv_crop_width);
-                }
-            }
-            
-            // V plane (half resolution)
-            for (int y = 0; y < uv_crop_height; y++) {
-                int src_y = uv_y1 + y;
-                if (src_y < height / 2) {
-                    uint8_t* src_line = frame->data[2] + src_y * frame->linesize[2] + uv_x1;
-                    uint8_t* dst_line = cropped_frame->data[2] + y * cropped_frame->linesize[2];
-                    memcpy(dst_line, src_line, uv_crop_width);
-                }
-            }
-            
             // Calculate center of gravity in pixel coordinates
             cv::Point2f center_of_gravity(obj.centerOfGravity.x * width, obj.centerOfGravity.y * height);
             
@@ -424,27 +435,74 @@ std::vector<AVFrame*> render_metadata_crop_to_avframe(AVFrame* frame, const Meta
             float distance = std::sqrt(std::pow(reference_point.x - center_of_gravity.x, 2) + 
                                      std::pow(reference_point.y - center_of_gravity.y, 2));
             
-            // Store frame with its distance
-            frames_with_distance.push_back({cropped_frame, distance});
+            batch.crops.push_back({cropped_frame, obj.objectId, distance});
         } else {
             std::cout << "[RENDER] Invalid crop dimensions: " << crop_width << "x" << crop_height << std::endl;
         }
     }
     
     // Sort by distance (closest first)
-    std::sort(frames_with_distance.begin(), frames_with_distance.end(),
-              [](const CroppedFrameWithDistance& a, const CroppedFrameWithDistance& b) {
+    std::sort(batch.crops.begin(), batch.crops.end(),
+              [](const PlateCrop& a, const PlateCrop& b) {
                   return a.distance < b.distance;
               });
-    
-    // Extract sorted frames
-    for (const auto& frame_with_dist : frames_with_distance) {
-        cropped_frames.push_back(frame_with_dist.frame);
+}
+
+// Pairs decoded frames with metadata and emits plate crops as fast as frames
+// decode. Display (if enabled) is a separate, optional sink fed from here.
+void sync_thread(AVFormatContext* formatContext, int video_stream_index, int data_stream_index) {
+    AVCodecParameters* vid_codecpar = formatContext->streams[video_stream_index]->codecpar;
+    int width = vid_codecpar->width;
+    int height = vid_codecpar->height;
+
+    AVRational time_base = formatContext->streams[video_stream_index]->time_base;
+
+    // PTS-ordered metadata index; each stream keeps its own time_base
+    AVRational metadata_time_base = formatContext->streams[data_stream_index]->time_base;
+    MetadataIndex metadata_index(metadata_time_base, time_base, metadata_index_config);
+    cv::Point2f custom_point(width * 0.5f, height * 1.0f); // N% from left, M% from top
+
+    AVFrame* frame = av_frame_alloc();
+    AVFrame* display_frame = av_frame_alloc(); // recycled ring slot
+    CropBatch crop_batch; // recycled ring slot
+    MetadataResult incoming_metadata; // recycled ring slot
+
+    while (run_threads) {
+        uint64_t wake_key = sync_wakeup.prepare_wait();
+        if (!frame_queue.try_pop(frame)) {
+            // No frame available, sleep until the decoder delivers one
+            sync_wakeup.wait(wake_key, WAKEUP_TIMEOUT);
+            continue;
+        }
+
+        // Index all metadata received so far
+        while (metadata_queue.try_pop(incoming_metadata)) {
+            metadata_index.insert(incoming_metadata);
+        }
+
+        // Drop stale entries, then find the metadata closest to this frame
+        metadata_index.expire(frame->pts);
+        const MetadataResult* current_metadata = metadata_index.match(frame->pts);
+
+        if (current_metadata) {
+            // Get cropped frames from metadata bounding boxes
+            crop_metadata_objects(frame, *current_metadata, width, height, crop_batch, custom_point);
+            cropped_frame_queue.push(crop_batch); // Ring takes ownership of the crop views
+        }
+
+        // Optional display sink gets its own reference to the frame
+        if (display_enabled && av_frame_ref(display_frame, frame) == 0) {
+            display_queue.push(display_frame);
+        }
     }
-    
-    return cropped_frames;
+
+    av_frame_free(&frame);
+    av_frame_free(&display_frame);
+    RingSlotTraits<CropBatch>::reset(crop_batch);
+    std::cout << "Sync thread finished." << std::endl;
 }
 
+// Optional SDL display sink with ffplay-style pacing. Not started in headless mode.
 void render_thread(AVFormatContext* formatContext, int video_stream_index) {
     if (SDL_Init(SDL_INIT_VIDEO) < 0) {
         std::cerr << "SDL could not initialize! SDL_Error: " << SDL_GetError() << std::endl;
@@ -485,76 +543,41 @@ void render_thread(AVFormatContext* formatContext, int video_stream_index) {
     AVRational time_base = formatContext->streams[video_stream_index]->time_base;
     
     // Frame timing variables (similar to ffplay)
-    double frame_timer = av_gettime_relative() / 1000000.0;
     double frame_last_delay = 0.04; // 25fps default
     const double AV_SYNC_THRESHOLD_MIN = 0.04;
     const double AV_SYNC_THRESHOLD_MAX = 0.1;
     const double AV_SYNC_FRAMEDUP_THRESHOLD = 0.1;
     
-    // Metadata sync buffer
-    std::vector<MetadataResult> metadata_buffer;
-    cv::Point2f custom_point(width * 0.5f, height * 1.0f); // N% from left, M% from top
-    
+    AVFrame* frame = av_frame_alloc();
+
+    // SDL events are only pumped from this thread, so don't sleep longer than this
+    const std::chrono::milliseconds SDL_EVENT_POLL_INTERVAL(20);
+
     while (run_threads) {
+        uint64_t wake_key = render_wakeup.prepare_wait();
+
         SDL_Event event;
         while (SDL_PollEvent(&event)) {
             if (event.type == SDL_QUIT) {
-                run_threads = false;
+                stop_threads();
                 break;
             }
         }
         
-        AVFrame* frame = nullptr;
-        if (frame_queue.try_pop(frame)) {
+        if (display_queue.try_pop(frame)) {
             // Calculate frame PTS in seconds
             double frame_pts = frame->pts * av_q2d(time_base);
             
             // Update video clock
             set_clock(&video_clock, frame_pts);
             
-            // Collect recent metadata for synchronization
-            MetadataResult current_metadata;
-            bool metadata_found = false;
-            
-            // Try to get metadata close to current frame PTS
-            while (metadata_queue.try_pop(current_metadata)) {
-                metadata_buffer.push_back(current_metadata);
-            }
-            
-            // Find best matching metadata based on PTS
-            if (!metadata_buffer.empty()) {
-                auto best_match = std::min_element(metadata_buffer.begin(), metadata_buffer.end(),
-                    [frame_pts, &time_base](const MetadataResult& a, const MetadataResult& b) {
-                        double a_pts = a.pts * av_q2d(time_base);
-                        double b_pts = b.pts * av_q2d(time_base);
-                        return std::abs(a_pts - frame_pts) < std::abs(b_pts - frame_pts);
-                    });
-                
-                double metadata_pts = best_match->pts * av_q2d(time_base);
-                if (std::abs(metadata_pts - frame_pts) < 0.1) { // 50ms tolerance
-                    current_metadata = *best_match;
-                    metadata_found = true;
-                }
-                
-                // Clean old metadata (keep only recent ones)
-                metadata_buffer.erase(
-                    std::remove_if(metadata_buffer.begin(), metadata_buffer.end(),
-                        [frame_pts, &time_base](const MetadataResult& meta) {
-                            double meta_pts = meta.pts * av_q2d(time_base);
-                            return (frame_pts - meta_pts) > 1.0; // Remove metadata older than 1 second
-                        }),
-                    metadata_buffer.end());
-            }
-            
             // Calculate timing for frame display (ffplay-style)
-            double current_time = av_gettime_relative() / 1000000.0;
             double delay = frame_pts - get_clock(&master_clock);
             
             // Adjust delay based on sync threshold
             if (delay <= -AV_SYNC_THRESHOLD_MAX) {
-                // Frame is too late, drop it
+                // Frame is too late, drop it (display only, crops were already emitted)
                 std::cout << "[RENDER] Dropping late frame, delay: " << delay << std::endl;
-                av_frame_free(&frame);
                 continue;
             } else if (delay >= AV_SYNC_FRAMEDUP_THRESHOLD) {
                 // Frame is too early, duplicate previous frame
@@ -576,25 +599,17 @@ void render_thread(AVFormatContext* formatContext, int video_stream_index) {
             // Update master clock
             set_clock(&master_clock, frame_pts);
             
-            // Render frame and metadata
+            // Render frame
             render_frame_to_sdl(renderer, texture, frame);
-            if (metadata_found) {
-                // render_metadata_overlay(renderer, current_metadata, width, height);
-
-                // Get cropped frames from metadata bounding boxes
-                std::vector<AVFrame*> cropped_frames = render_metadata_crop_to_avframe(frame, current_metadata, width, height, custom_point);
-                cropped_frame_queue.push(cropped_frames); // Vector is already copied by value
-            }
-            
             SDL_RenderPresent(renderer);
-            av_frame_free(&frame);
             
         } else {
-            // No frame available, wait a bit
-            SDL_Delay(10);
+            // No frame available, sleep until the sync stage delivers one
+            render_wakeup.wait(wake_key, SDL_EVENT_POLL_INTERVAL);
         }
     }
 
+    av_frame_free(&frame);
     SDL_DestroyTexture(texture);
     SDL_DestroyRenderer(renderer);
     SDL_DestroyWindow(window);
@@ -602,14 +617,33 @@ void render_thread(AVFormatContext* formatContext, int video_stream_index) {
     std::cout << "Render thread finished." << std::endl;
 }
 
+// Append newly recognised plates to the /bus_approach channel
+void publish_plates(BusSequence* bus_sequence, const std::vector<std::string>& ocr_results) {
+    size_t published = 0;
+    for (const std::string& plate : ocr_results) {
+        if (bus_sequence_publish(bus_sequence, plate.c_str())) {
+            published++;
+        } else {
+            std::cerr << "[OCR] Plate does not fit the shared memory slot: " << plate << std::endl;
+        }
+    }
+    if (published > 0) {
+        std::cout << "[OCR] Published " << published << " plates to shared memory (total "
+                  << bus_sequence->count << ")" << std::endl;
+    }
+}
+
 void ocr_thread() {
     std::cout << "[OCR] OCR thread started." << std::endl;
-    ocrProcessor.load_ocr("model.tflite", "labels.names");
+    if (!ocrPool.start(ocr_workers, "model.tflite", "labels.names", ocr_engine_config, &ocr_wakeup)) {
+        std::cerr << "[OCR] OCR workers not started, crops will be dropped" << std::endl;
+    }
     
     // Initialize shared memory
     const char * shm_name = "/bus_approach";
     const size_t shm_size = 4096;
-    void* shm_ptr;
+    void* shm_ptr = nullptr;
+    BusSequence* bus_sequence = nullptr;
 
     if (shm_name != nullptr && strlen(shm_name) > 0 && shm_size > 0) {
         int shm_fd = shm_open(shm_name, O_CREAT | O_RDWR, 0777);
@@ -625,9 +659,10 @@ void ocr_thread() {
                     std::cerr << "Failed to map shared memory: " << strerror(errno) << std::endl;
                     shm_ptr = nullptr;
                 } else {
-                    // Initialize shared memory to zero
-                    std::memset(shm_ptr, 0, shm_size);
-                    std::cout << "Shared memory initialized to zero: " << shm_name << " (" << shm_size << " bytes)" << std::endl;
+                    // Start a new epoch so readers drop their cursors from a previous run
+                    bus_sequence = static_cast<BusSequence*>(shm_ptr);
+                    bus_sequence_init(bus_sequence, std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        std::chrono::system_clock::now().time_since_epoch()).count());
                 }
                 close(shm_fd);
                 std::cout << "Shared memory initialized: " << shm_name << " (" << shm_size << " bytes)" << std::endl;
@@ -636,137 +671,276 @@ void ocr_thread() {
     }
 
     int frame_counter = 0;
+    OcrJob* pending_job = nullptr; // free job slot waiting for the next crop batch
+    // Tracker expiry and best-shot windows run on steady_clock seconds since
+    // this thread started, never on stream pts: a stalled stream or a pts
+    // jump must not expire tracks early or keep them alive
+    const auto clock_start = std::chrono::steady_clock::now();
+    auto clock_seconds = [&clock_start]() {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - clock_start).count();
+    };
+    plateTracker.configure(plate_tracker_config);
+    bestShots.configure(best_shot_config);
+    CropBatch incoming; // recycled ring slot; its crops move on to a job or the selector
+    std::vector<std::string> reported; // labels settled or expired by the tracker
+    std::vector<std::string> ocr_results;
     
     while(run_threads) {
-        std::vector<AVFrame*> cropped_frames;
-        std::vector<std::string> ocr_results;
-        if (cropped_frame_queue.try_pop(cropped_frames)) {
-            if (!cropped_frames.empty()) {
-                for (AVFrame* cropped_frame : cropped_frames) {
-                    // Convert AVFrame to cv::Mat for OCR processing
-                    cv::Mat bgr_mat;
-                    
-                    // Create SwsContext for YUV420P to BGR conversion
-                    SwsContext* sws_ctx = sws_getContext(
-                        cropped_frame->width, cropped_frame->height, AV_PIX_FMT_YUV420P,
-                        cropped_frame->width, cropped_frame->height, AV_PIX_FMT_BGR24,
-                        SWS_BILINEAR, nullptr, nullptr, nullptr
-                    );
-                    
-                    if (sws_ctx) {
-                        // Allocate BGR frame
-                        AVFrame* bgr_frame = av_frame_alloc();
-                        if (bgr_frame) {
-                            bgr_frame->format = AV_PIX_FMT_BGR24;
-                            bgr_frame->width = cropped_frame->width;
-                            bgr_frame->height = cropped_frame->height;
-                            
-                            if (av_frame_get_buffer(bgr_frame, 32) == 0) {
-                                // Convert YUV420P to BGR24
-                                sws_scale(sws_ctx, cropped_frame->data, cropped_frame->linesize, 
-                                         0, cropped_frame->height, bgr_frame->data, bgr_frame->linesize);
-                                
-                                // Create OpenCV Mat from BGR frame data
-                                bgr_mat = cv::Mat(cropped_frame->height, cropped_frame->width, CV_8UC3, 
-                                                bgr_frame->data[0], bgr_frame->linesize[0]).clone();
-                            }
-                            av_frame_free(&bgr_frame);
-                        }
-                        sws_freeContext(sws_ctx);
-                    }
-                    
-                    // Free the cropped AVFrame
-                    av_frame_free(&cropped_frame);
-                    
-                    if (!bgr_mat.empty()) {
-                        TFOCR::OCRResult result = ocrProcessor.run_ocr(bgr_mat);
-                        if (result.label.empty()) {
-                            // std::cout << "[OCR] Low confidence or empty label, skipping" << std::endl;
-                            continue;
-                        }
-                        // Check if the result already exists in ocr_results (no duplicates allowed)
-                        if (std::find(ocr_results.begin(), ocr_results.end(), result.label) == ocr_results.end()) {
-                            std::cout << "[OCR] Detected license plate: " << result.label << " conf : " << result.confidence << std::endl;
-                            ocr_results.push_back(result.label);
-                        } else {
-                            std::cout << "[OCR] Duplicate license plate skipped: " << result.label << " conf : " << result.confidence << std::endl;
-                        }
-                    }
+        uint64_t wake_key = ocr_wakeup.prepare_wait();
+        bool progressed = false;
+
+        // Count finished frames' reads as votes, strictly in frame order
+        while (OcrJob* job = ocrPool.nextCompleted()) {
+            for (size_t i = 0; i < job->results.size(); i++) {
+                const TFOCR::OCRResult& result = job->results[i];
+                if (result.label.empty()) {
+                    // std::cout << "[OCR] Low confidence or empty label, skipping" << std::endl;
+                    continue;
                 }
-                frame_counter++;
+                plateTracker.vote(job->batch.crops[i].objectId, result.label, result.confidence, reported);
             }
-        } else {
-            // No frame available, wait a bit
-            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            ocrPool.release(job);
+            frame_counter++;
+            progressed = true;
         }
 
-        // If shared memory is initialized, write results
-        if (shm_ptr != nullptr) {
-
-            json currents = json::array();
-            for (size_t i = 0; i < ocr_results.size(); ++i) {
-                currents.push_back({
-                    {"busNumber", ocr_results[i]}
-                });
+        // Hand new frames to the workers while job slots are free; when all
+        // are in flight the crop ring backs up and drops its oldest batches
+        while (true) {
+            if (!pending_job) {
+                pending_job = ocrPool.acquireJob();
             }
-            
-            // Read existing plates from shared memory
-            json existing_plates = json::array();
-            std::string existing_data((char*)shm_ptr);
-            if (!existing_data.empty()) {
-                try {
-                    existing_plates = json::parse(existing_data);
-                    if (!existing_plates.is_array()) {
-                        existing_plates = json::array();
-                    }
-                } catch (const json::exception& e) {
-                    std::cerr << "[OCR] Failed to parse existing JSON from shared memory: " << e.what() << std::endl;
-                    existing_plates = json::array();
-                }
+            if (!pending_job) {
+                break;
             }
-            
-            // Filter out duplicates from ocr_results that already exist in shared memory
-            std::vector<std::string> new_unique_plates;
-            for (const std::string& new_plate : ocr_results) {
-                bool already_exists = false;
-                for (const auto& existing_plate : existing_plates) {
-                    if (existing_plate.contains("busNumber") && 
-                        existing_plate["busNumber"].get<std::string>() == new_plate) {
-                        already_exists = true;
-                        break;
+            CropBatch& ready = pending_job->batch;
+
+            bool popped = cropped_frame_queue.try_pop(incoming);
+            if (popped) {
+                progressed = true;
+                double now = clock_seconds();
+                plateTracker.expire(now, reported);
+
+                for (PlateCrop& crop : incoming.crops) {
+                    if (!plateTracker.wantsOcr(crop.objectId, now)) {
+                        // Settled objects are not read again; drop their crop views now
+                        release_crop_view(crop.frame);
+                    } else if (bestShots.enabled()) {
+                        bestShots.offer(crop, now);
+                    } else {
+                        ready.pts = incoming.pts;
+                        ready.crops.push_back(crop);
+                        crop.frame = nullptr;
                     }
                 }
-                if (!already_exists) {
-                    new_unique_plates.push_back(new_plate);
-                }
+                incoming.crops.clear();
             }
-            
-            // Create final list: keep existing plates and add new unique ones
-            json final_plates = existing_plates;
-            for (const std::string& unique_plate : new_unique_plates) {
-                final_plates.push_back({
-                    {"busNumber", unique_plate}
-                });
+
+            // Best crops of every window that has closed
+            bestShots.collect(clock_seconds(), ready);
+
+            if (!ready.crops.empty()) {
+                ocrPool.submit(pending_job);
+                pending_job = nullptr;
+                progressed = true;
             }
-            
-            // Clear and write final results to shared memory
-            std::string final_json = final_plates.dump();
-            if (final_json.size() < shm_size - 1) {  // Leave space for null terminator
-                std::memset(shm_ptr, 0, shm_size);  // Clear shared memory
-                std::memcpy(shm_ptr, final_json.c_str(), final_json.size());
-                std::cout << "[OCR] Updated shared memory with " << final_plates.size() << " plates" << std::endl;
-            } else {
-                std::cerr << "[OCR] JSON data too large for shared memory buffer" << std::endl;
+            if (!popped) {
+                break;
             }
+        }
+
+        // Without new crops (plates gone, decoder idle) time still passes
+        plateTracker.expire(clock_seconds(), reported);
+
+        if (!reported.empty()) {
+            ocr_results.clear();
+            for (const std::string& label : reported) {
+                // Check if the result already exists in ocr_results (no duplicates allowed)
+                if (std::find(ocr_results.begin(), ocr_results.end(), label) == ocr_results.end()) {
+                    std::cout << "[OCR] Detected license plate: " << label << std::endl;
+                    ocr_results.push_back(label);
+                } else {
+                    std::cout << "[OCR] Duplicate license plate skipped: " << label << std::endl;
+                }
+            }
+            reported.clear();
+
+            // Only new plates are published; readers pick them up after their cursor
+            if (bus_sequence != nullptr) {
+                publish_plates(bus_sequence, ocr_results);
+            }
+        }
+
+        if (!progressed) {
+            // Sleep until the sync stage delivers crops or a worker finishes a frame
+            ocr_wakeup.wait(wake_key, WAKEUP_TIMEOUT);
+        }
+    }
+    ocrPool.stop();
+    bestShots.clear();
+    RingSlotTraits<CropBatch>::reset(incoming);
+    if (pending_job) {
+        ocrPool.release(pending_job);
+    }
+}
 
+void print_queue_stats(const char* name, const QueueStats& stats) {
+    std::cout << "[STATS] " << name
+              << " occupancy " << stats.occupancy << "/" << stats.capacity
+              << " (peak " << stats.high_watermark << ")"
+              << " pushed " << stats.pushed
+              << " popped " << stats.popped
+              << " dropped_oldest " << stats.dropped_oldest
+              << " dropped_newest " << stats.dropped_newest
+              << " timeouts " << stats.timeouts << std::endl;
+}
+
+// Periodically report pipeline queue occupancy and drop counters
+void stats_thread() {
+    const std::chrono::milliseconds interval(10000);
+
+    while (run_threads) {
+        uint64_t wake_key = stats_wakeup.prepare_wait();
+        if (stats_wakeup.wait(wake_key, interval)) {
+            continue; // woken for shutdown
+        }
+
+        print_queue_stats("video_packet_queue", video_packet_queue.stats());
+        print_queue_stats("metadata_packet_queue", metadata_packet_queue.stats());
+        print_queue_stats("frame_queue", frame_queue.stats());
+        print_queue_stats("display_queue", display_queue.stats());
+        print_queue_stats("metadata_queue", metadata_queue.stats());
+        print_queue_stats("cropped_frame_queue", cropped_frame_queue.stats());
+
+        PoolStats crop_pool = crop_pool_stats();
+        std::cout << "[STATS] crop_frame_pool in_use " << crop_pool.in_use << "/" << crop_pool.capacity
+                  << " (peak " << crop_pool.peak_in_use << ")"
+                  << " acquired " << crop_pool.acquired
+                  << " allocations " << crop_pool.allocations << std::endl;
+        PlateTrackerStats tracker = plateTracker.stats();
+        uint64_t tracker_crops = tracker.ocr_crops + tracker.skipped_crops;
+        std::cout << "[STATS] plate_tracker tracked " << tracker.tracked
+                  << " settled " << tracker.settled
+                  << " expired " << tracker.expired
+                  << " ocr_crops " << tracker.ocr_crops
+                  << " skipped_crops " << tracker.skipped_crops
+                  << " (" << (tracker_crops ? 100.0 * tracker.skipped_crops / tracker_crops : 0.0) << "% skipped)"
+                  << std::endl;
+        if (bestShots.enabled()) {
+            BestShotStats best = bestShots.stats();
+            std::cout << "[STATS] best_shot offered " << best.offered
+                      << " selected " << best.selected
+                      << " (" << (best.offered ? 100.0 * best.selected / best.offered : 0.0) << "% OCRed)"
+                      << " held " << best.held << std::endl;
+        }
+        OcrPoolStats ocr_pool = ocrPool.stats();
+        std::cout << "[STATS] ocr_pool in_flight " << ocr_pool.in_flight << " (peak " << ocr_pool.peak_in_flight << ")";
+        for (size_t i = 0; i < ocr_pool.workers.size(); i++) {
+            const OcrWorkerStats& worker = ocr_pool.workers[i];
+            std::cout << " | worker" << i << " crops " << worker.crops
+                      << " stolen " << worker.stolen
+                      << " batches " << worker.batches
+                      << " queued " << worker.queued;
+        }
+        std::cout << std::endl;
+        if (debug_recorder().enabled()) {
+            DebugRecorderStats debug = debug_recorder().stats();
+            std::cout << "[STATS] debug_recorder recorded " << debug.recorded
+                      << " dropped " << debug.dropped
+                      << " failed " << debug.failed
+                      << " bytes " << debug.bytes << std::endl;
+        }
+        BufferPoolStats decoder_pool = videoProcessor.bufferPoolStats();
+        std::cout << "[STATS] decoder_buffer_pool acquired " << decoder_pool.acquired
+                  << " allocations " << decoder_pool.allocations
+                  << " bytes " << decoder_pool.allocated_bytes << std::endl;
+
+        DecodeGovernorStats governor = decodeGovernor.stats();
+        std::cout << "[STATS] decoder " << (governor.idle ? "idle" : "full")
+                  << " to_idle " << governor.to_idle
+                  << " to_full " << governor.to_full
+                  << " switch_latency_ms last " << governor.last_latency_ms
+                  << " avg " << governor.avg_latency_ms
+                  << " max " << governor.max_latency_ms << std::endl;
+        if (decodeGovernor.buffersGop()) {
+            GopBufferStats gop = gopBuffer.stats();
+            std::cout << "[STATS] gop_buffer packets " << gop.packets
+                      << " bytes " << gop.bytes
+                      << " (peak " << gop.peak_packets << " packets, " << gop.peak_bytes << " bytes)"
+                      << " overflows " << gop.overflows
+                      << " catchup_ms last " << governor.last_catchup_ms
+                      << " (" << governor.last_catchup_packets << " packets)"
+                      << " avg " << governor.avg_catchup_ms
+                      << " max " << governor.max_catchup_ms << std::endl;
         }
     }
 }
 
-int main() {
+int main(int argc, char* argv[]) {
 
     const char* url = "rtsp://192.168.0.64/profile2/media.smp";
 
+    if (argc > 1 && strcmp(argv[1], "--bench") == 0) {
+        return run_bench(argc - 2, argv + 2);
+    }
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--headless") == 0) {
+            display_enabled = false; // no SDL window, no display pacing
+        } else if (strcmp(argv[i], "--match-tolerance") == 0 && i + 1 < argc) {
+            metadata_index_config.match_tolerance = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--ocr-config") == 0 && i + 1 < argc) {
+            ocr_engine_config_path = argv[++i];
+        } else if (strcmp(argv[i], "--debug-config") == 0 && i + 1 < argc) {
+            debug_config_path = argv[++i];
+        } else if (strcmp(argv[i], "--ocr-batch") == 0 && i + 1 < argc) {
+            ocrPool.setMaxBatchSize(atoi(argv[++i]));
+        } else if (strcmp(argv[i], "--ocr-workers") == 0 && i + 1 < argc) {
+            ocr_workers = std::max(1, atoi(argv[++i]));
+        } else if (strcmp(argv[i], "--ocr-votes") == 0 && i + 1 < argc) {
+            plate_tracker_config.votes = std::max(1, atoi(argv[++i]));
+        } else if (strcmp(argv[i], "--ocr-vote-confidence") == 0 && i + 1 < argc) {
+            plate_tracker_config.vote_confidence = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--track-expiry") == 0 && i + 1 < argc) {
+            plate_tracker_config.expiry = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--best-shots") == 0 && i + 1 < argc) {
+            best_shot_config.shots = std::max(1, atoi(argv[++i]));
+        } else if (strcmp(argv[i], "--best-shot-window") == 0 && i + 1 < argc) {
+            best_shot_config.window = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--idle-timeout") == 0 && i + 1 < argc) {
+            decode_governor_config.idle_timeout = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--idle-mode") == 0 && i + 1 < argc) {
+            const char* mode = argv[++i];
+            if (strcmp(mode, "gop") == 0) {
+                decode_governor_config.idle_strategy = IdleStrategy::GopBuffer;
+            } else if (strcmp(mode, "discard") == 0) {
+                decode_governor_config.idle_strategy = IdleStrategy::Discard;
+            } else {
+                std::cerr << "Unknown --idle-mode " << mode << " (gop|discard)" << std::endl;
+                return -1;
+            }
+        } else if (strcmp(argv[i], "--idle-discard") == 0 && i + 1 < argc) {
+            const char* level = argv[++i];
+            if (strcmp(level, "nonref") == 0) {
+                decode_governor_config.idle_discard = AVDISCARD_NONREF;
+            } else if (strcmp(level, "nonkey") == 0) {
+                decode_governor_config.idle_discard = AVDISCARD_NONKEY;
+            } else {
+                std::cerr << "Unknown --idle-discard " << level << " (nonkey|nonref)" << std::endl;
+                return -1;
+            }
+        }
+    }
+    decodeGovernor.configure(decode_governor_config);
+    if (!load_ocr_engine_config(ocr_engine_config_path, ocr_engine_config)) {
+        std::cout << "[OCR] " << ocr_engine_config_path << " not loaded, using default engine settings" << std::endl;
+    }
+    DebugRecorderConfig debug_config;
+    load_debug_recorder_config(debug_config_path, debug_config);
+    std::cout << "Debug recorder: " << describe_debug_recorder_config(debug_config) << std::endl;
+    debug_recorder().start(debug_config);
+    std::cout << "Display: " << (display_enabled ? "SDL" : "headless") << std::endl;
+
     // Set log level to reduce swscaler warnings
     av_log_set_level(AV_LOG_ERROR);
 
@@ -813,22 +987,41 @@ int main() {
     set_clock_at(&video_clock, 0.0, start_time);
     set_clock_at(&master_clock, 0.0, start_time);
 
+    // Each ring wakes the thread that consumes it
+    video_packet_queue.set_notifier(&decode_wakeup);
+    metadata_packet_queue.set_notifier(&metadata_wakeup);
+    frame_queue.set_notifier(&sync_wakeup);
+    display_queue.set_notifier(&render_wakeup);
+    cropped_frame_queue.set_notifier(&ocr_wakeup);
+
     std::cout << "Starting threads..." << std::endl;
     std::thread streamThread(stream_thread, formatContext, data_stream_index, video_stream_index);
     std::thread decodeThread(decode_thread, formatContext, video_stream_index);
-    std::thread renderThread(render_thread, formatContext, video_stream_index);
+    std::thread metadataThread(metadata_thread, formatContext->streams[data_stream_index]->time_base);
+    std::thread syncThread(sync_thread, formatContext, video_stream_index, data_stream_index);
+    std::thread renderThread;
+    if (display_enabled) {
+        renderThread = std::thread(render_thread, formatContext, video_stream_index);
+    }
     std::thread ocrThread(ocr_thread);
+    std::thread statsThread(stats_thread);
 
     // std::cout << "Press Enter to stop..." << std::endl;
     getchar();
     
     std::cout << "Stopping threads..." << std::endl;
-    run_threads = false;
+    stop_threads();
 
     streamThread.join();
     decodeThread.join();
-    renderThread.join();
+    metadataThread.join();
+    syncThread.join();
+    if (renderThread.joinable()) {
+        renderThread.join();
+    }
     ocrThread.join();
+    statsThread.join();
+    debug_recorder().stop();
 
     avformat_close_input(&formatContext);
     avformat_network_deinit();
@@ -0,0 +1,93 @@
+#include "metadata_index.hpp"
+
+#include <cmath>
+#include <utility>
+
+MetadataIndex::MetadataIndex(AVRational metadata_time_base, AVRational video_time_base,
+                             const MetadataIndexConfig& config)
+    : config_(config),
+      metadata_time_base_(av_q2d(metadata_time_base)),
+      video_time_base_(av_q2d(video_time_base)),
+      slots_(config.capacity ? config.capacity : 1),
+      head_(0), count_(0) {
+}
+
+size_t MetadataIndex::lower_bound(double seconds) const {
+    size_t lo = 0;
+    size_t hi = count_;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (at(mid).seconds < seconds) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+void MetadataIndex::pop_front() {
+    head_ = (head_ + 1) % slots_.size();
+    count_--;
+}
+
+void MetadataIndex::insert(MetadataResult& result) {
+    double seconds = result.pts * metadata_time_base_;
+
+    // Full: evict the oldest entry
+    if (count_ == slots_.size()) {
+        pop_front();
+    }
+
+    // Append, then bubble back into order. Metadata arrives in order almost
+    // always, so this is usually a single comparison.
+    size_t pos = count_++;
+    Entry& tail = at(pos);
+    tail.seconds = seconds;
+    std::swap(tail.result, result);
+
+    while (pos > 0 && at(pos - 1).seconds > seconds) {
+        std::swap(at(pos - 1), at(pos));
+        pos--;
+    }
+}
+
+const MetadataResult* MetadataIndex::match(int64_t frame_pts) const {
+    if (count_ == 0) {
+        return nullptr;
+    }
+
+    double seconds = frame_pts * video_time_base_;
+    size_t pos = lower_bound(seconds);
+
+    // Closest of the two neighbours around the insertion point
+    const Entry* best = nullptr;
+    if (pos < count_) {
+        best = &at(pos);
+    }
+    if (pos > 0) {
+        const Entry& before = at(pos - 1);
+        if (!best || std::abs(before.seconds - seconds) <= std::abs(best->seconds - seconds)) {
+            best = &before;
+        }
+    }
+
+    if (std::abs(best->seconds - seconds) < config_.match_tolerance) {
+        return &best->result;
+    }
+    return nullptr;
+}
+
+void MetadataIndex::expire(int64_t frame_pts) {
+    double seconds = frame_pts * video_time_base_;
+
+    // Timeline jumped backwards (stream restart): nothing buffered is usable
+    if (count_ > 0 && at(0).seconds > seconds + config_.max_age) {
+        clear();
+        return;
+    }
+
+    while (count_ > 0 && seconds - at(0).seconds > config_.max_age) {
+        pop_front();
+    }
+}
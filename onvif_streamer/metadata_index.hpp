@@ -0,0 +1,62 @@
+#ifndef METADATA_INDEX_HPP
+#define METADATA_INDEX_HPP
+
+extern "C" {
+#include <libavutil/rational.h>
+}
+
+#include <cstddef>
+#include <vector>
+
+#include "parser.hpp"
+
+struct MetadataIndexConfig {
+    size_t capacity = 64;           // entries kept at most, oldest evicted first
+    double match_tolerance = 0.1;   // seconds between frame and metadata PTS
+    double max_age = 1.0;           // seconds behind the newest frame before expiry
+};
+
+// --- PTS-ordered metadata index ---
+// Fixed-capacity ring kept sorted by presentation time, so matching a frame
+// is a binary search. Metadata PTS are converted with the metadata stream's
+// own time_base and frame PTS with the video stream's, so the two streams
+// may run on different clocks.
+class MetadataIndex {
+public:
+    MetadataIndex(AVRational metadata_time_base, AVRational video_time_base,
+                  const MetadataIndexConfig& config = MetadataIndexConfig());
+
+    // Swaps `result` into the index; `result` comes back with recycled storage
+    void insert(MetadataResult& result);
+
+    // Closest entry within the match tolerance, or nullptr. The pointer stays
+    // valid until the next insert() or expire().
+    const MetadataResult* match(int64_t frame_pts) const;
+
+    // Drop entries older than max_age relative to `frame_pts`
+    void expire(int64_t frame_pts);
+
+    size_t size() const { return count_; }
+    void clear() { head_ = 0; count_ = 0; }
+
+private:
+    struct Entry {
+        double seconds;
+        MetadataResult result;
+    };
+
+    Entry& at(size_t i) { return slots_[(head_ + i) % slots_.size()]; }
+    const Entry& at(size_t i) const { return slots_[(head_ + i) % slots_.size()]; }
+    size_t lower_bound(double seconds) const;
+    void pop_front();
+
+    MetadataIndexConfig config_;
+    double metadata_time_base_;
+    double video_time_base_;
+
+    std::vector<Entry> slots_;
+    size_t head_;
+    size_t count_;
+};
+
+#endif // METADATA_INDEX_HPP
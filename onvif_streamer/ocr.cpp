@@ -1,8 +1,22 @@
 #include "ocr.hpp"
 #include <algorithm>
-#include <numeric>
+#include <chrono>
 #include <cmath>
 
+#include "debug_recorder.hpp"
+
+namespace {
+
+// Sampled copy of the resized model input, written off-thread
+void record_ocr_input(const cv::Mat& resized_input) {
+    static const DebugTag tag = debug_recorder().tag("ocr_input");
+    if (debug_recorder().sample(tag)) {
+        debug_recorder().record(tag, resized_input, "ocr_input.jpg");
+    }
+}
+
+} // namespace
+
 void TFOCR::save(const cv::Mat& img, const std::string& filename) {
     cv::imwrite(filename, img);
 }
@@ -122,74 +136,45 @@ std::map<int, std::string> TFOCR::loadLabelMap(const std::string& path) {
     return label_map;
 }
 
-std::vector<int> TFOCR::ctcGreedyDecoder(const float* logits, int time, int classes) {
-    std::vector<int> result;
-    int prev = -1;
-    for (int t = 0; t < time; ++t) {
-        int max_index = 0;
-        float max_val = logits[t * classes];
-        for (int c = 1; c < classes; ++c) {
-            float val = logits[t * classes + c];
-            if (val > max_val) {
-                max_val = val;
-                max_index = c;
-            }
-        }
-        if (max_index != prev && max_index != 0) {
-            result.push_back(max_index);
-        }
-        prev = max_index;
+void TFOCR::load_ocr(const std::string& model_path, const std::string& labels_path,
+                     const OcrEngineConfig& engine_config) {
+    // Load TFLite model (mmap'd)
+    std::shared_ptr<tflite::FlatBufferModel> loaded_model = tflite::FlatBufferModel::BuildFromFile(model_path.c_str());
+    if (!loaded_model) {
+        std::cerr << "[OCR] Failed to load model " << model_path << std::endl;
+        return;
     }
-    return result;
+    load_ocr(loaded_model, labels_path, engine_config);
 }
 
-float TFOCR::getConfidence(const float* logits, int time, int classes, const std::string& mode) {
-    std::vector<float> confidences;
-    int blank = 0; // blank token index
-    
-    for (int t = 0; t < time; ++t) {
-        // Find max index and value for this timestep
-        int max_index = 0;
-        float max_val = logits[t * classes];
-        for (int c = 1; c < classes; ++c) {
-            float val = logits[t * classes + c];
-            if (val > max_val) {
-                max_val = val;
-                max_index = c;
-            }
-        }
-        
-        // Skip blank tokens
-        if (max_index == blank) continue;
-        
-        // Apply exponential (assuming logits are log probabilities)
-        float confidence = std::exp(max_val);
-        confidences.push_back(confidence);
-    }
-    
-    if (confidences.empty()) {
-        return 0.0f;
-    }
-    
-    if (mode == "min") {
-        return *std::min_element(confidences.begin(), confidences.end());
-    } else {
-        // mean mode
-        float sum = std::accumulate(confidences.begin(), confidences.end(), 0.0f);
-        return sum / confidences.size();
-    }
-}
-
-void TFOCR::load_ocr(const std::string& model_path, const std::string& labels_path) {
+void TFOCR::load_ocr(std::shared_ptr<tflite::FlatBufferModel> shared_model, const std::string& labels_path,
+                     const OcrEngineConfig& engine_config) {
     // Load label map
     label_map = loadLabelMap(labels_path);
 
-    // Load TFLite model
-    model = tflite::FlatBufferModel::BuildFromFile(model_path.c_str());
-    tflite::ops::builtin::BuiltinOpResolver resolver;
-    // Removed local interpreter declaration, now using member variable
-    tflite::InterpreterBuilder(*model, resolver)(&interpreter);
-    interpreter->AllocateTensors();
+    // Build the interpreter with the engine settings
+    model = shared_model;
+    interpreter = build_ocr_interpreter(*model, engine_config);
+    if (!interpreter) {
+        return;
+    }
+    std::cout << "[OCR] Engine: " << describe_ocr_engine_config(engine_config) << std::endl;
+
+    // float32 or fully integer (int8/uint8) quantized models
+    TfLiteTensor* input_tensor = interpreter->tensor(interpreter->inputs()[0]);
+    const TfLiteTensor* output_tensor = interpreter->tensor(interpreter->outputs()[0]);
+    if (!ocr_tensor_type_supported(input_tensor) || !ocr_tensor_type_supported(output_tensor)) {
+        std::cerr << "[OCR] Unsupported model tensors: input " << ocr_tensor_type_name(input_tensor)
+                  << ", output " << ocr_tensor_type_name(output_tensor) << std::endl;
+        interpreter.reset();
+        return;
+    }
+    std::cout << "[OCR] Model input " << ocr_tensor_type_name(input_tensor)
+              << ", output " << ocr_tensor_type_name(output_tensor) << std::endl;
+
+    // Remember the input shape; run_ocr_batch only changes its batch dimension
+    input_dims.assign(input_tensor->dims->data, input_tensor->dims->data + input_tensor->dims->size);
+    current_batch = input_dims.empty() ? 1 : input_dims[0];
 }
 
 std::string TFOCR::removeRegionalName(const std::string& text) {
@@ -220,41 +205,178 @@ std::string TFOCR::removeRegionalName(const std::string& text) {
 }
 
 TFOCR::OCRResult TFOCR::run_ocr(const cv::Mat& input_img) {
+    if (!resize_batch(1)) {
+        return {"", 0.0f};
+    }
 
-    // Enhanced image preprocessing for better OCR accuracy
-    cv::Mat processed_img = input_img.clone();
-    
     // 3. Convert to grayscale
     cv::Mat gray;
-    cv::cvtColor(processed_img, gray, cv::COLOR_BGR2GRAY);
+    cv::cvtColor(input_img, gray, cv::COLOR_BGR2GRAY);
     
     // 6. Resize to model input size
-    cv::resize(gray, gray, cv::Size(192, 96), 0, 0, cv::INTER_LANCZOS4);
+    cv::resize(gray, resized_input, cv::Size(INPUT_WIDTH, INPUT_HEIGHT), 0, 0, cv::INTER_LANCZOS4);
     
-    cv::imwrite("debug_ocr_input.jpg", gray); // Debugging line
-    gray.convertTo(gray, CV_32FC1, 1.0 / 255.0);
+    record_ocr_input(resized_input);
 
-    // Set input
-    float* input = interpreter->typed_input_tensor<float>(0);
-    memcpy(input, gray.data, 96 * 192 * sizeof(float));
+    // Normalize (and quantize, if needed) straight into the input tensor
+    write_ocr_input(resized_input, 1.0 / 255.0, 0.0, false, interpreter->tensor(interpreter->inputs()[0]), 0);
 
-    // Run inference
-    if (interpreter->Invoke() != kTfLiteOk) {
+    return invoke_and_decode();
+}
+
+TFOCR::OCRResult TFOCR::run_ocr_luma(const uint8_t* luma, int stride, int width, int height, bool full_range) {
+    if (!luma || width <= 0 || height <= 0) {
+        return {"", 0.0f};
+    }
+
+    if (!resize_batch(1)) {
+        return {"", 0.0f};
+    }
+    fill_input_luma({luma, stride, width, height, full_range}, 0);
+    return invoke_and_decode();
+}
+
+void TFOCR::run_ocr_batch(const LumaImage* crops, size_t count, std::vector<OCRResult>& results) {
+    results.clear();
+
+    for (size_t first = 0; first < count; ) {
+        int batch = static_cast<int>(std::min<size_t>(count - first, max_batch_size));
+        if (!resize_batch(batch)) {
+            // The model cannot take this batch size; fall back to one crop per invoke
+            std::cerr << "[OCR] Batch size " << batch << " not supported, disabling batching" << std::endl;
+            max_batch_size = 1;
+            if (batch == 1 || !resize_batch(1)) {
+                results.resize(count, {"", 0.0f});
+                return;
+            }
+            continue;
+        }
+
+        for (int b = 0; b < batch; ++b) {
+            const LumaImage& crop = crops[first + b];
+            if (!crop.data || crop.width <= 0 || crop.height <= 0) {
+                clear_ocr_input(interpreter->tensor(interpreter->inputs()[0]), b);
+                continue;
+            }
+            fill_input_luma(crop, b);
+        }
+
+        if (!invoke()) {
+            results.resize(first + batch, {"", 0.0f});
+        } else {
+            // Output is [batch, time, classes]. Resizing only touches the
+            // input, so a model with a fixed output batch still runs; its
+            // logits would be read past the end of the tensor.
+            const TfLiteTensor* output = interpreter->tensor(interpreter->outputs()[0]);
+            if (output->dims->size != 3 || output->dims->data[0] != batch) {
+                if (batch > 1) {
+                    std::cerr << "[OCR] Output batch does not follow input batch " << batch
+                              << ", disabling batching" << std::endl;
+                    max_batch_size = 1;
+                    if (resize_batch(1)) {
+                        continue; // redo this chunk one crop per invoke
+                    }
+                } else {
+                    std::cerr << "[OCR] Unexpected output shape, expected [1, time, classes]" << std::endl;
+                }
+                results.resize(count, {"", 0.0f});
+                return;
+            }
+            int time = output->dims->data[1];
+            int classes = output->dims->data[2];
+            size_t logits = static_cast<size_t>(time) * classes;
+            for (int b = 0; b < batch; ++b) {
+                const LumaImage& crop = crops[first + b];
+                if (!crop.data || crop.width <= 0 || crop.height <= 0) {
+                    results.push_back({"", 0.0f});
+                    continue;
+                }
+                results.push_back(decode_output(read_ocr_output(output, b * logits, logits, dequantized_output),
+                                                time, classes));
+            }
+        }
+        first += batch;
+    }
+}
+
+// Change the batch dimension of the input tensor, re-planning the arena only
+// when it actually changes
+bool TFOCR::resize_batch(int batch) {
+    if (!interpreter) {
+        return false;
+    }
+    if (batch == current_batch) {
+        return true;
+    }
+    if (input_dims.empty()) {
+        return false;
+    }
+    std::vector<int> dims = input_dims;
+    dims[0] = batch;
+    if (interpreter->ResizeInputTensor(interpreter->inputs()[0], dims) != kTfLiteOk ||
+        interpreter->AllocateTensors() != kTfLiteOk) {
+        // Restore the previous shape so single-crop OCR keeps working
+        dims[0] = current_batch;
+        interpreter->ResizeInputTensor(interpreter->inputs()[0], dims);
+        interpreter->AllocateTensors();
+        return false;
+    }
+    current_batch = batch;
+    return true;
+}
+
+// Resize a luma plane to the model input and normalize it into batch entry
+// `batch_index` of the input tensor
+void TFOCR::fill_input_luma(const LumaImage& image, int batch_index) {
+    // Wrap the plane without copying, then resize to model input size
+    cv::Mat luma_view(image.height, image.width, CV_8UC1, const_cast<uint8_t*>(image.data), image.stride);
+    cv::resize(luma_view, resized_input, cv::Size(INPUT_WIDTH, INPUT_HEIGHT), 0, 0, cv::INTER_LANCZOS4);
+
+    record_ocr_input(resized_input);
+
+    // Normalize (and quantize, if needed) straight into the input tensor
+    TfLiteTensor* input = interpreter->tensor(interpreter->inputs()[0]);
+    if (image.full_range) {
+        write_ocr_input(resized_input, 1.0 / 255.0, 0.0, false, input, batch_index);
+    } else {
+        // Limited range (16..235) -> 0..1, matching what a YUV->BGR->gray conversion produced
+        write_ocr_input(resized_input, 1.0 / 219.0, -16.0 / 219.0, true, input, batch_index);
+    }
+}
+
+bool TFOCR::invoke() {
+    auto start = std::chrono::steady_clock::now();
+    TfLiteStatus status = interpreter->Invoke();
+    last_invoke_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    if (status != kTfLiteOk) {
         std::cerr << "ocr inference failed..." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+TFOCR::OCRResult TFOCR::invoke_and_decode() {
+    // Run inference
+    if (!invoke()) {
         return {"", 0.0f};
     }
 
     // Decode output
     auto output_details = interpreter->tensor(interpreter->outputs()[0]);
-    const float* output_data = output_details->data.f;
     int time = output_details->dims->data[1];
     int classes = output_details->dims->data[2];
+    const float* output_data = read_ocr_output(output_details, 0, static_cast<size_t>(time) * classes, dequantized_output);
+
+    return decode_output(output_data, time, classes);
+}
 
-    std::vector<int> indices = ctcGreedyDecoder(output_data, time, classes);
+TFOCR::OCRResult TFOCR::decode_output(const float* output_data, int time, int classes) {
+    // Labels and confidence in one pass over the logits
+    ctc_greedy_decode(output_data, time, classes, ctc_result);
 
     // Convert indices to characters
     std::string result;
-    for (int idx : indices) {
+    for (int idx : ctc_result.indices) {
         if (label_map.count(idx)) {
             result += label_map[idx];
         }
@@ -266,7 +388,7 @@ TFOCR::OCRResult TFOCR::run_ocr(const cv::Mat& input_img) {
     
     
     // Calculate confidence
-    float confidence = getConfidence(output_data, time, classes, "min");
+    float confidence = ctc_result.min_confidence;
     confidence = std::round(confidence * 10000.0f) / 10000.0f; // Round to 4 decimal places
     
     // Return empty result if confidence is too low
@@ -279,4 +401,4 @@ TFOCR::OCRResult TFOCR::run_ocr(const cv::Mat& input_img) {
     }
 
     return {result, confidence};
-}
\ No newline at end of file
+}
@@ -1,6 +1,7 @@
 #ifndef OCR_HPP
 #define OCR_HPP
 
+#include <algorithm>
 #include <iostream>
 #include <fstream>
 #include <opencv2/opencv.hpp>
@@ -11,21 +12,57 @@
 #include <vector>
 #include <string>
 
+#include "ocr_engine.hpp"
+#include "ocr_tensor.hpp"
+#include "ctc_decode.hpp"
+
 class TFOCR {
     public:
-        void load_ocr(const std::string& model_path, const std::string& labels_path);
+        void load_ocr(const std::string& model_path, const std::string& labels_path,
+                      const OcrEngineConfig& engine_config = OcrEngineConfig());
+        // Build this engine's own interpreter on an already loaded model, so
+        // several engines share one mmap'd FlatBufferModel
+        void load_ocr(std::shared_ptr<tflite::FlatBufferModel> shared_model, const std::string& labels_path,
+                      const OcrEngineConfig& engine_config = OcrEngineConfig());
+        bool loaded() const { return interpreter != nullptr; }
         cv::Mat preprocess_plate(const cv::Mat& input_img, int index);
         struct OCRResult {
             std::string label;
             float confidence;
         };
+        // An 8-bit luma plane, e.g. the Y plane of a YUV crop view
+        struct LumaImage {
+            const uint8_t* data;
+            int stride;
+            int width;
+            int height;
+            bool full_range;    // false: limited range (16..235)
+        };
         OCRResult run_ocr(const cv::Mat& input_img);
+        // OCR straight from an 8-bit luma plane (e.g. the Y plane of a YUV crop),
+        // without any colour conversion. Limited-range luma is expanded to full range.
+        OCRResult run_ocr_luma(const uint8_t* luma, int stride, int width, int height, bool full_range = false);
+        // OCR `count` crops with one Invoke() per batch. The input tensor is
+        // resized to the number of crops (up to the max batch size), so the
+        // interpreter overhead is paid once per frame instead of once per
+        // plate. `results` receives one entry per crop, in order.
+        void run_ocr_batch(const LumaImage* crops, size_t count, std::vector<OCRResult>& results);
+
+        // Upper bound for run_ocr_batch, 1 disables batching
+        void setMaxBatchSize(int size) { max_batch_size = std::max(1, size); }
+        int getMaxBatchSize() const { return max_batch_size; }
         
         // Set confidence threshold (default: 0.5)
         void setConfidenceThreshold(float threshold) { min_confidence_threshold = threshold; }
         float getConfidenceThreshold() const { return min_confidence_threshold; }
+
+        // Duration of the most recent Invoke()
+        double lastInvokeMs() const { return last_invoke_ms; }
         
     private:
+        static constexpr int INPUT_WIDTH = 192;
+        static constexpr int INPUT_HEIGHT = 96;
+
         std::string preprocess_dir;
         float min_confidence_threshold = 0.35f; // Default threshold: 40%
 
@@ -36,12 +73,24 @@ class TFOCR {
         bool extract_plate_region(const cv::Mat& input, cv::Mat& output_plate);
         
         std::map<int, std::string> loadLabelMap(const std::string& path);
-        std::vector<int> ctcGreedyDecoder(const float* logits, int time, int classes);
-        float getConfidence(const float* logits, int time, int classes, const std::string& mode = "min");
         std::string removeRegionalName(const std::string& text);
+        bool invoke();
+        OCRResult invoke_and_decode();
+        bool resize_batch(int batch);
+        void fill_input_luma(const LumaImage& image, int batch_index);
+        OCRResult decode_output(const float* logits, int time, int classes);
+
+        cv::Mat resized_input; // reused model-size grayscale buffer
+        std::vector<float> dequantized_output; // logits of quantized models
+        CtcDecodeResult ctc_result;            // reused decode buffers
+
+        int max_batch_size = 4;
+        int current_batch = 1;              // batch dimension of the input tensor
+        std::vector<int> input_dims;        // model input shape, batch first
+        double last_invoke_ms = 0.0;
 
         std::map<int, std::string> label_map;
-        std::unique_ptr<tflite::FlatBufferModel> model;
+        std::shared_ptr<tflite::FlatBufferModel> model;
         std::unique_ptr<tflite::Interpreter> interpreter; // Added interpreter as a member
 };
 
@@ -0,0 +1,248 @@
+#include "ocr_pool.hpp"
+
+#include <chrono>
+#include <iostream>
+
+extern "C" {
+#include <libavutil/pixfmt.h>
+}
+
+namespace {
+
+// Upper bound on a worker's sleep, so stop() is noticed without traffic
+const std::chrono::milliseconds WORKER_WAKEUP_TIMEOUT(100);
+
+} // namespace
+
+// --- TaskQueue ---
+
+void OcrWorkerPool::TaskQueue::push(const Task& task) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (count_ == ring_.size()) {
+        // Grow, unrolling the ring; only happens until the peak load is seen
+        std::vector<Task> grown(ring_.size() * 2);
+        for (size_t i = 0; i < count_; i++) {
+            grown[i] = ring_[(head_ + i) % ring_.size()];
+        }
+        ring_.swap(grown);
+        head_ = 0;
+    }
+    ring_[(head_ + count_) % ring_.size()] = task;
+    count_++;
+}
+
+size_t OcrWorkerPool::TaskQueue::popFront(Task* out, size_t max) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t n = std::min(max, count_);
+    for (size_t i = 0; i < n; i++) {
+        out[i] = ring_[head_];
+        head_ = (head_ + 1) % ring_.size();
+    }
+    count_ -= n;
+    return n;
+}
+
+bool OcrWorkerPool::TaskQueue::stealBack(Task& out) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (count_ == 0) {
+        return false;
+    }
+    count_--;
+    out = ring_[(head_ + count_) % ring_.size()];
+    return true;
+}
+
+size_t OcrWorkerPool::TaskQueue::size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return count_;
+}
+
+// --- OcrWorkerPool ---
+
+OcrWorkerPool::OcrWorkerPool(size_t max_jobs)
+    : jobs_(max_jobs ? max_jobs : 1),
+      in_flight_(jobs_.size()) {
+    free_.reserve(jobs_.size());
+    for (OcrJob& job : jobs_) {
+        free_.push_back(&job);
+    }
+}
+
+OcrWorkerPool::~OcrWorkerPool() {
+    stop();
+    for (OcrJob& job : jobs_) {
+        RingSlotTraits<CropBatch>::reset(job.batch);
+    }
+}
+
+bool OcrWorkerPool::start(size_t workers, const std::string& model_path, const std::string& labels_path,
+                          const OcrEngineConfig& engine_config, EventNotifier* done) {
+    if (workers == 0) {
+        workers = 1;
+    }
+
+    // One mmap'd model, one interpreter per worker
+    std::shared_ptr<tflite::FlatBufferModel> model = tflite::FlatBufferModel::BuildFromFile(model_path.c_str());
+    if (!model) {
+        std::cerr << "[OCR] Failed to load model " << model_path << std::endl;
+        return false;
+    }
+
+    OcrEngineConfig worker_config = engine_config;
+    worker_config.threads = std::max(1, engine_config.threads / static_cast<int>(workers));
+
+    for (size_t i = 0; i < workers; i++) {
+        std::unique_ptr<Worker> worker = std::make_unique<Worker>();
+        worker->ocr.load_ocr(model, labels_path, worker_config);
+        if (!worker->ocr.loaded()) {
+            std::cerr << "[OCR] Failed to build interpreter for worker " << i << std::endl;
+            workers_.clear();
+            return false;
+        }
+        worker->ocr.setMaxBatchSize(max_batch_size_);
+        worker->ocr.setConfidenceThreshold(confidence_threshold_);
+        workers_.push_back(std::move(worker));
+    }
+
+    done_ = done;
+    running_ = true;
+    for (size_t i = 0; i < workers_.size(); i++) {
+        workers_[i]->thread = std::thread(&OcrWorkerPool::workerLoop, this, i);
+    }
+    std::cout << "[OCR] " << workers_.size() << " workers, " << worker_config.threads
+              << " interpreter thread(s) each" << std::endl;
+    return true;
+}
+
+void OcrWorkerPool::stop() {
+    if (!running_.exchange(false)) {
+        return;
+    }
+    work_.notify();
+    for (std::unique_ptr<Worker>& worker : workers_) {
+        if (worker->thread.joinable()) {
+            worker->thread.join();
+        }
+    }
+}
+
+OcrJob* OcrWorkerPool::acquireJob() {
+    if (free_.empty()) {
+        return nullptr;
+    }
+    OcrJob* job = free_.back();
+    free_.pop_back();
+    return job;
+}
+
+void OcrWorkerPool::submit(OcrJob* job) {
+    size_t count = job->batch.crops.size();
+    job->sequence = next_sequence_++;
+    job->results.resize(count);
+    job->remaining.store(count);
+
+    in_flight_[(in_flight_head_ + in_flight_count_) % in_flight_.size()] = job;
+    size_t in_flight = ++in_flight_count_;
+    if (in_flight > peak_in_flight_.load()) {
+        peak_in_flight_ = in_flight;
+    }
+
+    if (count == 0 || workers_.empty()) {
+        job->remaining.store(0);
+        return;
+    }
+
+    // Deal the crops round-robin; idle workers even out the rest by stealing
+    for (size_t i = 0; i < count; i++) {
+        workers_[next_worker_]->queue.push({job, i});
+        next_worker_ = (next_worker_ + 1) % workers_.size();
+    }
+    work_.notify();
+}
+
+OcrJob* OcrWorkerPool::nextCompleted() {
+    if (in_flight_count_ == 0) {
+        return nullptr;
+    }
+    OcrJob* job = in_flight_[in_flight_head_];
+    if (job->remaining.load() != 0) {
+        return nullptr; // later jobs wait for this one, keeping frame order
+    }
+    in_flight_head_ = (in_flight_head_ + 1) % in_flight_.size();
+    in_flight_count_--;
+    return job;
+}
+
+void OcrWorkerPool::release(OcrJob* job) {
+    RingSlotTraits<CropBatch>::reset(job->batch);
+    free_.push_back(job);
+}
+
+size_t OcrWorkerPool::takeTasks(size_t id, Task* out, size_t max) {
+    Worker& self = *workers_[id];
+    size_t n = self.queue.popFront(out, max);
+    if (n > 0) {
+        return n;
+    }
+
+    // Own queue is empty: steal from the back of a peer's
+    for (size_t step = 1; step < workers_.size() && n < max; step++) {
+        Worker& victim = *workers_[(id + step) % workers_.size()];
+        while (n < max && victim.queue.stealBack(out[n])) {
+            n++;
+        }
+    }
+    self.stolen += n;
+    return n;
+}
+
+void OcrWorkerPool::workerLoop(size_t id) {
+    Worker& self = *workers_[id];
+    size_t max = static_cast<size_t>(self.ocr.getMaxBatchSize());
+    std::vector<Task> tasks(max);
+    std::vector<TFOCR::LumaImage> inputs;
+    std::vector<TFOCR::OCRResult> outputs;
+    inputs.reserve(max);
+
+    while (running_) {
+        uint64_t wake_key = work_.prepare_wait();
+        size_t n = takeTasks(id, tasks.data(), max);
+        if (n == 0) {
+            work_.wait(wake_key, WORKER_WAKEUP_TIMEOUT);
+            continue;
+        }
+
+        // OCR reads the Y plane of each crop view directly, no colour conversion
+        inputs.clear();
+        for (size_t i = 0; i < n; i++) {
+            const AVFrame* crop = tasks[i].job->batch.crops[tasks[i].index].frame;
+            bool full_range = crop->color_range == AVCOL_RANGE_JPEG ||
+                              crop->format == AV_PIX_FMT_YUVJ420P;
+            inputs.push_back({crop->data[0], crop->linesize[0], crop->width, crop->height, full_range});
+        }
+
+        // Crops from different frames may share an invoke
+        self.ocr.run_ocr_batch(inputs.data(), n, outputs);
+        self.batches++;
+        self.crops += n;
+
+        for (size_t i = 0; i < n; i++) {
+            OcrJob* job = tasks[i].job;
+            std::swap(job->results[tasks[i].index], outputs[i]);
+            if (job->remaining.fetch_sub(1) == 1 && done_) {
+                done_->notify();
+            }
+        }
+    }
+}
+
+OcrPoolStats OcrWorkerPool::stats() const {
+    OcrPoolStats stats;
+    stats.in_flight = in_flight_count_.load();
+    stats.peak_in_flight = peak_in_flight_.load();
+    for (const std::unique_ptr<Worker>& worker : workers_) {
+        stats.workers.push_back({worker->crops.load(), worker->stolen.load(), worker->batches.load(),
+                                 worker->queue.size()});
+    }
+    return stats;
+}
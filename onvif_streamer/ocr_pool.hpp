@@ -0,0 +1,127 @@
+#ifndef OCR_POOL_HPP
+#define OCR_POOL_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "crop.hpp"
+#include "event_notifier.hpp"
+#include "ocr.hpp"
+#include "ocr_engine.hpp"
+
+// One frame's worth of OCR work. The job owns the crop batch (and with it
+// the crop views) until the results have been published.
+struct OcrJob {
+    uint64_t sequence = 0;
+    CropBatch batch;
+    std::vector<TFOCR::OCRResult> results;  // one per crop, in crop order
+    std::atomic<size_t> remaining{0};       // crops not yet recognised
+};
+
+struct OcrWorkerStats {
+    uint64_t crops = 0;         // crops recognised by this worker
+    uint64_t stolen = 0;        // of which taken from another worker's queue
+    uint64_t batches = 0;       // run_ocr_batch calls
+    size_t queued = 0;          // crops waiting in this worker's queue
+};
+
+struct OcrPoolStats {
+    size_t in_flight = 0;       // jobs submitted but not yet handed back
+    size_t peak_in_flight = 0;
+    std::vector<OcrWorkerStats> workers;
+};
+
+// --- OCR worker pool ---
+// N threads, each with its own interpreter built on one shared mmap'd
+// model. Crops of a submitted job are dealt round-robin onto per-worker
+// queues; a worker drains its own queue front first (up to the batch size
+// per invoke) and steals from the back of a peer's queue when it runs dry,
+// so one slow plate does not hold up the others. Completed jobs come back
+// out of nextCompleted() strictly in submission (frame) order.
+//
+// acquireJob/submit/nextCompleted/release belong to a single dispatcher
+// thread; `done` is notified whenever a job finishes.
+class OcrWorkerPool {
+public:
+    explicit OcrWorkerPool(size_t max_jobs = 8);
+    ~OcrWorkerPool();
+
+    // Loads the model once and starts `workers` threads. The engine's
+    // `threads` budget is split across the workers (at least 1 each).
+    bool start(size_t workers, const std::string& model_path, const std::string& labels_path,
+               const OcrEngineConfig& engine_config, EventNotifier* done);
+    void stop();
+
+    // Applied to the workers by start()
+    void setMaxBatchSize(int size) { max_batch_size_ = std::max(1, size); }
+    void setConfidenceThreshold(float threshold) { confidence_threshold_ = threshold; }
+
+    // A free job slot, nullptr while all are in flight
+    OcrJob* acquireJob();
+    // Queue the job's crops; its batch must be filled in
+    void submit(OcrJob* job);
+    // The oldest submitted job if it has finished, else nullptr
+    OcrJob* nextCompleted();
+    // Return a published job; its crop views are released
+    void release(OcrJob* job);
+
+    size_t workerCount() const { return workers_.size(); }
+    OcrPoolStats stats() const;
+
+private:
+    struct Task {
+        OcrJob* job;
+        size_t index;           // crop within the job
+    };
+
+    // Mutex-guarded deque on a ring; the owner pops the front, thieves the back
+    class TaskQueue {
+    public:
+        void push(const Task& task);
+        size_t popFront(Task* out, size_t max);
+        bool stealBack(Task& out);
+        size_t size() const;
+    private:
+        mutable std::mutex mutex_;
+        std::vector<Task> ring_ = std::vector<Task>(16);
+        size_t head_ = 0;
+        size_t count_ = 0;
+    };
+
+    struct Worker {
+        TFOCR ocr;
+        TaskQueue queue;
+        std::thread thread;
+        std::atomic<uint64_t> crops{0};
+        std::atomic<uint64_t> stolen{0};
+        std::atomic<uint64_t> batches{0};
+    };
+
+    void workerLoop(size_t id);
+    size_t takeTasks(size_t id, Task* out, size_t max);
+
+    std::vector<OcrJob> jobs_;
+    std::vector<OcrJob*> free_;             // dispatcher only
+    std::vector<OcrJob*> in_flight_;        // ring in submission order, dispatcher only
+    size_t in_flight_head_ = 0;
+    std::atomic<size_t> in_flight_count_{0};  // also read by stats()
+    std::atomic<size_t> peak_in_flight_{0};
+    uint64_t next_sequence_ = 0;
+    size_t next_worker_ = 0;
+
+    std::vector<std::unique_ptr<Worker>> workers_;
+    EventNotifier work_;                    // wakes idle workers
+    EventNotifier* done_ = nullptr;
+    std::atomic<bool> running_{false};
+    int max_batch_size_ = 4;
+    float confidence_threshold_ = 0.35f;
+};
+
+#endif // OCR_POOL_HPP
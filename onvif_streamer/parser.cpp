@@ -1,154 +1,305 @@
 #include "parser.hpp"
-#include <vector>
-
-using namespace tinyxml2;
-
-std::vector<Object> MetadataParser::extractObj(XMLElement* root) {
-    std::vector<Object> objItems;
-    if (!root) return objItems;
-
-    XMLElement* analytics = root->FirstChildElement("tt:VideoAnalytics");
-    if (!analytics) return objItems;
-
-    XMLElement* frame = analytics->FirstChildElement("tt:Frame");
-    if (!frame) return objItems;
-
-    for (XMLElement* obj = frame->FirstChildElement("tt:Object"); obj; obj = obj->NextSiblingElement("tt:Object")) {
-        const char* objectId = obj->Attribute("ObjectId");
-        if (!objectId) continue;
-
-        const char* Lp = "LicensePlate";
-        Object objItem;
-        objItem.typeName = "Unknown";
-        objItem.objectId = std::stoi(objectId);
-        objItem.confidence = 0.0;
-        objItem.boundingBox = {0.0, 0.0, 0.0, 0.0};
-        objItem.centerOfGravity = {0.0, 0.0};
-
-        XMLElement* appearance = obj->FirstChildElement("tt:Appearance");
-        if (appearance) {
-            XMLElement* shape = appearance->FirstChildElement("tt:Shape");
-            if (shape) {
-                XMLElement* bbox = shape->FirstChildElement("tt:BoundingBox");
-                if (bbox) {
-                    bbox->QueryDoubleAttribute("left", &objItem.boundingBox.left);
-                    bbox->QueryDoubleAttribute("top", &objItem.boundingBox.top);
-                    bbox->QueryDoubleAttribute("right", &objItem.boundingBox.right);
-                    bbox->QueryDoubleAttribute("bottom", &objItem.boundingBox.bottom);
-                }
-                XMLElement* cog = shape->FirstChildElement("tt:CenterOfGravity");
-                if (cog) {
-                    cog->QueryDoubleAttribute("x", &objItem.centerOfGravity.x);
-                    cog->QueryDoubleAttribute("y", &objItem.centerOfGravity.y);
-                }
-            }
+#include <cstdlib>
+#include <cstring>
 
-            XMLElement* classElem = appearance->FirstChildElement("tt:Class");
-            if (classElem) {
-                XMLElement* type = classElem->FirstChildElement("tt:Type");
-                if (type) {
-                    // Only process LicensePlate type objects
-                    if (strcmp(type->GetText(), Lp) == 0) {
-                        objItem.typeName = type->GetText();
-                        type->QueryDoubleAttribute("Likelihood", &objItem.confidence);
-                        objItems.push_back(objItem);
-                    }
-                }
-            }
+namespace {
+
+inline bool is_space(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+// Value of `name="..."` inside a start tag, nullptr if absent. The value is
+// always followed by its closing quote inside [begin, end), which stops
+// strtod/strtol.
+const char* find_attribute(const char* begin, const char* end, const char* name, size_t len) {
+    const char* p = begin;
+    while (end - p >= static_cast<ptrdiff_t>(len + 2)) {
+        p = static_cast<const char*>(memchr(p, name[0], end - p));
+        if (!p || end - p < static_cast<ptrdiff_t>(len + 2)) {
+            return nullptr;
+        }
+        if ((p == begin || is_space(p[-1])) && memcmp(p, name, len) == 0 &&
+            p[len] == '=' && (p[len + 1] == '"' || p[len + 1] == '\'')) {
+            return p + len + 2;
         }
+        ++p;
     }
-    return objItems;
+    return nullptr;
 }
 
-void MetadataParser::processXmlDoc(XMLDocument& doc, std::vector<Object>& result) {
-    XMLElement* root = doc.RootElement();
-    if (!root) {
-        std::cerr << "No root element found" << std::endl;
-        return;
+template<size_t N>
+bool read_float(const char* begin, const char* end, const char (&name)[N], float& out) {
+    const char* value = find_attribute(begin, end, name, N - 1);
+    if (!value) {
+        return false;
     }
+    out = strtof(value, nullptr);
+    return true;
+}
 
-    std::vector<Object> detections = extractObj(root);
-    if (!detections.empty()) {
-        result.insert(result.end(), detections.begin(), detections.end());
-    }
+template<size_t N>
+bool equals(const char* s, size_t len, const char (&literal)[N]) {
+    return len == N - 1 && memcmp(s, literal, N - 1) == 0;
+}
+
+} // namespace
+
+MetadataParser::MetadataParser() {
+    tag_buffer_.reserve(256);
+    current_objects_.reserve(16);
+    resetStream();
 }
 
 void MetadataParser::processPacket(AVPacket* packet) {
     if (!packet || !packet->data || packet->size <= 0) return;
 
-    xml_buffer.append(reinterpret_cast<const char*>(packet->data), packet->size);
-    processBuffer(packet->pts);
+    processBytes(packet->data, packet->size, packet->pts);
 }
 
-void MetadataParser::processBuffer(int64_t pts) {
-    size_t pos = 0;
-    const std::string xml_declaration = "<?xml version=\"1.0\" encoding=\"UTF-8\"?>";
+void MetadataParser::processBytes(const uint8_t* data, size_t size, int64_t pts) {
+    const char* p = reinterpret_cast<const char*>(data);
+    const char* end = p + size;
 
-    while ((pos = xml_buffer.find("<tt:MetadataStream", pos)) != std::string::npos) {
-        size_t end_pos = xml_buffer.find("</tt:MetadataStream>", pos);
-        if (end_pos == std::string::npos) {
-            // Not a complete element, break and wait for more data
-            break;
+    while (p < end) {
+        if (in_tag_) {
+            const char* close = static_cast<const char*>(memchr(p, '>', end - p));
+            if (!close) {
+                // Tag continues in the next packet
+                if (tag_buffer_.size() + (end - p) > MAX_TAG_SIZE) {
+                    std::cerr << "[PARSER] Oversized tag, resyncing" << std::endl;
+                    tag_buffer_.clear();
+                    in_tag_ = false;
+                    resetStream();
+                } else {
+                    tag_buffer_.append(p, end);
+                }
+                return;
+            }
+            if (tag_buffer_.empty()) {
+                handleTag(p, close, pts);
+            } else {
+                tag_buffer_.append(p, close);
+                handleTag(tag_buffer_.data(), tag_buffer_.data() + tag_buffer_.size(), pts);
+                tag_buffer_.clear();
+            }
+            in_tag_ = false;
+            p = close + 1;
+        } else {
+            const char* open = static_cast<const char*>(memchr(p, '<', end - p));
+            const char* text_end = open ? open : end;
+            if (capture_type_text_) {
+                appendTypeText(p, text_end);
+            }
+            if (!open) {
+                return;
+            }
+            in_tag_ = true;
+            p = open + 1;
         }
-        size_t element_end = end_pos + std::string("</tt:MetadataStream>").length();
-        std::string complete_element = xml_buffer.substr(pos, element_end - pos);
-        
-        // Store the complete XML string with its PTS
-        completed_streams.emplace_back(xml_declaration + complete_element, pts);
-        
-        // Erase the processed part from the buffer
-        xml_buffer.erase(0, element_end);
-        pos = 0; // Reset position to search from the beginning of the modified buffer
-    }
-    processCompletedStreams();
-    cleanupBuffer();
+    }
 }
 
-void MetadataParser::processCompletedStreams() {
-    if (completed_streams.empty()) return;
+// [begin, end) is everything between '<' and '>'
+void MetadataParser::handleTag(const char* begin, const char* end, int64_t pts) {
+    if (begin == end || *begin == '?' || *begin == '!') {
+        return; // declaration, comment
+    }
+
+    bool closing = (*begin == '/');
+    const char* name = closing ? begin + 1 : begin;
+    const char* name_end = name;
+    while (name_end < end && !is_space(*name_end) && *name_end != '/') {
+        ++name_end;
+    }
+
+    Tag tag = TAG_OTHER;
+    size_t len = name_end - name;
+    if (len > 3 && memcmp(name, "tt:", 3) == 0) {
+        const char* local = name + 3;
+        len -= 3;
+        if (equals(local, len, "MetadataStream")) tag = TAG_METADATA_STREAM;
+        else if (equals(local, len, "VideoAnalytics")) tag = TAG_VIDEO_ANALYTICS;
+        else if (equals(local, len, "Frame")) tag = TAG_FRAME;
+        else if (equals(local, len, "Object")) tag = TAG_OBJECT;
+        else if (equals(local, len, "Appearance")) tag = TAG_APPEARANCE;
+        else if (equals(local, len, "Shape")) tag = TAG_SHAPE;
+        else if (equals(local, len, "BoundingBox")) tag = TAG_BOUNDING_BOX;
+        else if (equals(local, len, "CenterOfGravity")) tag = TAG_CENTER_OF_GRAVITY;
+        else if (equals(local, len, "Class")) tag = TAG_CLASS;
+        else if (equals(local, len, "Type")) tag = TAG_TYPE;
+    }
+
+    if (closing) {
+        handleEnd(tag, pts);
+        return;
+    }
 
-    for (const auto& stream_pair : completed_streams) {
-        const std::string& xmlString = stream_pair.first;
-        int64_t pts = stream_pair.second;
+    bool self_closing = (end[-1] == '/');
+    handleStart(tag, name_end, self_closing ? end - 1 : end);
+    if (self_closing) {
+        handleEnd(tag, pts);
+    }
+}
+
+void MetadataParser::handleStart(Tag tag, const char* attrs, const char* attrs_end) {
+    if (tag == TAG_METADATA_STREAM) {
+        resetStream(); // a new document also resyncs after a truncated one
+        in_stream_ = true;
+    }
+    if (depth_ < MAX_DEPTH) {
+        stack_[depth_] = tag;
+    }
+    int depth = depth_++;
+    if (!in_stream_) {
+        return;
+    }
 
-        XMLDocument doc;
-        if (doc.Parse(xmlString.c_str()) == XML_SUCCESS) {
-            std::vector<Object> objects;
-            processXmlDoc(doc, objects);
-            if (!objects.empty()) {
-                results.push_back({pts, objects});
+    switch (tag) {
+    case TAG_OBJECT:
+        if (!frame_done_ && tagAt(depth - 1) == TAG_FRAME && tagAt(depth - 2) == TAG_VIDEO_ANALYTICS) {
+            const char* id = find_attribute(attrs, attrs_end, "ObjectId", 8);
+            if (!id) {
+                break;
             }
-        } else {
-            std::cerr << "Failed to parse XML: " << doc.ErrorStr() << std::endl;
+            in_object_ = true;
+            object_depth_ = depth;
+            type_seen_ = false;
+            current_object_ = Object{static_cast<int32_t>(strtol(id, nullptr, 10)), 0.0f,
+                                     {0.0f, 0.0f, 0.0f, 0.0f}, {0.0f, 0.0f}, ObjectType::Unknown};
         }
+        break;
+
+    case TAG_BOUNDING_BOX:
+        if (in_object_ && depth == object_depth_ + 3 &&
+            tagAt(depth - 1) == TAG_SHAPE && tagAt(depth - 2) == TAG_APPEARANCE) {
+            read_float(attrs, attrs_end, "left", current_object_.boundingBox.left);
+            read_float(attrs, attrs_end, "top", current_object_.boundingBox.top);
+            read_float(attrs, attrs_end, "right", current_object_.boundingBox.right);
+            read_float(attrs, attrs_end, "bottom", current_object_.boundingBox.bottom);
+        }
+        break;
+
+    case TAG_CENTER_OF_GRAVITY:
+        if (in_object_ && depth == object_depth_ + 3 &&
+            tagAt(depth - 1) == TAG_SHAPE && tagAt(depth - 2) == TAG_APPEARANCE) {
+            read_float(attrs, attrs_end, "x", current_object_.centerOfGravity.x);
+            read_float(attrs, attrs_end, "y", current_object_.centerOfGravity.y);
+        }
+        break;
+
+    case TAG_TYPE:
+        // Only the first class candidate counts
+        if (in_object_ && !type_seen_ && depth == object_depth_ + 3 &&
+            tagAt(depth - 1) == TAG_CLASS && tagAt(depth - 2) == TAG_APPEARANCE) {
+            type_seen_ = true;
+            type_likelihood_ = 0.0f;
+            read_float(attrs, attrs_end, "Likelihood", type_likelihood_);
+            type_length_ = 0;
+            capture_type_text_ = true;
+        }
+        break;
+
+    default:
+        break;
     }
-    completed_streams.clear();
 }
 
-std::vector<MetadataResult> MetadataParser::getCompletedResults() {
-    std::vector<MetadataResult> completed = std::move(results);
-    results.clear();
-    return completed;
-}
+void MetadataParser::handleEnd(Tag tag, int64_t pts) {
+    if (depth_ == 0) {
+        return; // stray end tag before any document
+    }
+    int depth = --depth_;
+    if (depth < MAX_DEPTH && stack_[depth] != tag) {
+        std::cerr << "[PARSER] Mismatched end tag, dropping document" << std::endl;
+        resetStream();
+        return;
+    }
+    if (!in_stream_) {
+        return;
+    }
 
-void MetadataParser::cleanupBuffer() {
-    const size_t MAX_BUFFER_SIZE = 512 * 1024; // 512KB
-    if (xml_buffer.size() > MAX_BUFFER_SIZE) {
-        size_t next_metadata = xml_buffer.find("<tt:MetadataStream");
-        if (next_metadata != std::string::npos) {
-            xml_buffer.erase(0, next_metadata);
-        } else {
-            // If no start tag is found, keep the end of the buffer
-            xml_buffer.erase(0, xml_buffer.size() - 1024); 
+    switch (tag) {
+    case TAG_TYPE:
+        if (capture_type_text_) {
+            capture_type_text_ = false;
+            if (equals(type_text_, type_length_, "LicensePlate")) {
+                current_object_.type = ObjectType::LicensePlate;
+                current_object_.confidence = type_likelihood_;
+            }
+        }
+        break;
+
+    case TAG_OBJECT:
+        if (in_object_ && depth == object_depth_) {
+            in_object_ = false;
+            // Only process LicensePlate type objects
+            if (current_object_.type == ObjectType::LicensePlate) {
+                current_objects_.push_back(current_object_);
+            }
+        }
+        break;
+
+    case TAG_FRAME:
+        if (tagAt(depth - 1) == TAG_VIDEO_ANALYTICS) {
+            frame_done_ = true;
+        }
+        break;
+
+    case TAG_VIDEO_ANALYTICS:
+        if (tagAt(depth - 1) == TAG_METADATA_STREAM) {
+            frame_done_ = true;
+        }
+        break;
+
+    case TAG_METADATA_STREAM:
+        if (!current_objects_.empty()) {
+            if (completed_ == results.size()) {
+                results.emplace_back();
+            }
+            MetadataResult& result = results[completed_++];
+            result.pts = pts;
+            result.objects.assign(current_objects_.begin(), current_objects_.end());
         }
+        resetStream();
+        break;
+
+    default:
+        break;
     }
 }
 
-size_t MetadataParser::getBufferSize() const {
-    return xml_buffer.size();
+void MetadataParser::appendTypeText(const char* begin, const char* end) {
+    size_t len = end - begin;
+    if (type_length_ + len > MAX_TYPE_TEXT) {
+        type_length_ = MAX_TYPE_TEXT + 1; // too long to be a known type
+        return;
+    }
+    memcpy(type_text_ + type_length_, begin, len);
+    type_length_ += len;
 }
 
-void MetadataParser::debugBuffer() {
-    // Implementation of debugBuffer can be added here if needed
+void MetadataParser::resetStream() {
+    depth_ = 0;
+    in_stream_ = false;
+    in_object_ = false;
+    frame_done_ = false;
+    object_depth_ = 0;
+    type_seen_ = false;
+    capture_type_text_ = false;
+    type_length_ = 0;
+    current_objects_.clear();
 }
 
+bool MetadataParser::popCompletedResult(MetadataResult& result) {
+    if (read_ == completed_) {
+        read_ = 0;
+        completed_ = 0;
+        return false;
+    }
+    std::swap(result, results[read_++]);
+    return true;
+}
+
+size_t MetadataParser::getBufferSize() const {
+    return tag_buffer_.size();
+}
@@ -1,32 +1,38 @@
 #ifndef PARSER_HPP
 #define PARSER_HPP
 
-#include <tinyxml2.h>
 #include <iostream>
-#include <algorithm>
 #include <string>
-#include <mutex>
 #include <vector>
+#include <cstddef>
 #include <cstdint>
 
 extern "C" {
 #include <libavcodec/avcodec.h>
 }
 
+#include "spsc_ring.hpp"
+
 struct BoundingBox {
-    double left, top, right, bottom;
+    float left, top, right, bottom;   // Hanwha 3840x2160 pixel space
 };
 
 struct Point {
-    double x, y;
+    float x, y;                       // normalized 0..1
+};
+
+enum class ObjectType : uint8_t {
+    Unknown = 0,
+    LicensePlate
 };
 
+// Plain data, copied by value through the rings
 struct Object {
-    std::string typeName;
-    int objectId;
-    double confidence;
+    int32_t objectId;
+    float confidence;                 // tt:Type Likelihood
     BoundingBox boundingBox;
     Point centerOfGravity;
+    ObjectType type;
 };
 
 struct MetadataResult {
@@ -34,23 +40,92 @@ struct MetadataResult {
     std::vector<Object> objects;
 };
 
+// Results are recycled through the rings; keep the object storage
+template<>
+struct RingSlotTraits<MetadataResult> {
+    static MetadataResult make() { return {AV_NOPTS_VALUE, {}}; }
+    static void reset(MetadataResult& result) {
+        result.pts = AV_NOPTS_VALUE;
+        result.objects.clear();
+    }
+    static void dispose(MetadataResult&) {}
+};
+
+// --- Streaming ONVIF metadata parser ---
+// Bytes are scanned once as they arrive; only tags are looked at and only
+// the few elements the pipeline needs are decoded:
+//
+//   tt:MetadataStream/tt:VideoAnalytics/tt:Frame/tt:Object[@ObjectId]
+//     tt:Appearance/tt:Shape/tt:BoundingBox, tt:CenterOfGravity
+//     tt:Appearance/tt:Class/tt:Type[@Likelihood]
+//
+// A tag split across RTP packets is carried over in a small buffer; no
+// document is ever assembled. Only LicensePlate objects are reported, and
+// like the DOM parser only those of the first tt:Frame of the first
+// tt:VideoAnalytics.
 class MetadataParser {
 private:
-    std::string xml_buffer;
-    std::vector<std::pair<std::string, int64_t>> completed_streams;
+    enum Tag : uint8_t {
+        TAG_OTHER,
+        TAG_METADATA_STREAM,
+        TAG_VIDEO_ANALYTICS,
+        TAG_FRAME,
+        TAG_OBJECT,
+        TAG_APPEARANCE,
+        TAG_SHAPE,
+        TAG_BOUNDING_BOX,
+        TAG_CENTER_OF_GRAVITY,
+        TAG_CLASS,
+        TAG_TYPE
+    };
+
+    static constexpr int MAX_DEPTH = 32;
+    static constexpr size_t MAX_TAG_SIZE = 4096;    // resync if a tag grows past this
+    static constexpr size_t MAX_TYPE_TEXT = 16;
+
+    // Element path of the current position
+    Tag stack_[MAX_DEPTH];
+    int depth_ = 0;
+
+    // Tag scanning across packet boundaries
+    bool in_tag_ = false;
+    std::string tag_buffer_;
+
+    bool in_stream_ = false;
+    bool in_object_ = false;
+    bool frame_done_ = false;       // first Frame already read, ignore later ones
+    int object_depth_ = 0;
+    bool type_seen_ = false;
+    bool capture_type_text_ = false;
+    char type_text_[MAX_TYPE_TEXT];
+    size_t type_length_ = 0;
+    float type_likelihood_ = 0.0f;
+    Object current_object_;
+    std::vector<Object> current_objects_;
+
+    // Completed documents; entries are reused, only [read_, completed_) is live
     std::vector<MetadataResult> results;
+    size_t completed_ = 0;
+    size_t read_ = 0;
 
-    std::vector<Object> extractObj(tinyxml2::XMLElement* element);
-    void processXmlDoc(tinyxml2::XMLDocument& doc, std::vector<Object>& result);
-    void cleanupBuffer();
-    void processCompletedStreams();
+    Tag tagAt(int depth) const { return depth >= 0 && depth < MAX_DEPTH ? stack_[depth] : TAG_OTHER; }
+    void handleTag(const char* begin, const char* end, int64_t pts);
+    void handleStart(Tag tag, const char* attrs, const char* attrs_end);
+    void handleEnd(Tag tag, int64_t pts);
+    void appendTypeText(const char* begin, const char* end);
+    void resetStream();
 
 public:
+    MetadataParser();
+
     void processPacket(AVPacket* packet);
-    void processBuffer(int64_t pts);
+    // Feed raw bytes; completed MetadataStream documents are stamped with `pts`
+    void processBytes(const uint8_t* data, size_t size, int64_t pts);
+    // Bytes held for an unfinished tag
     size_t getBufferSize() const;
-    void debugBuffer();
-    std::vector<MetadataResult> getCompletedResults();
+    // Swaps the oldest completed result into `result`, whose storage is
+    // kept for reuse. Returns false when there is none.
+    bool popCompletedResult(MetadataResult& result);
 };
 
-#endif // PARSER_HPP
\ No newline at end of file
+#endif // PARSER_HPP
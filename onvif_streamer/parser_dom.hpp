@@ -0,0 +1,39 @@
+#ifndef PARSER_DOM_HPP
+#define PARSER_DOM_HPP
+
+#include <tinyxml2.h>
+#include "parser.hpp"
+#include <iostream>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+}
+
+// The original tinyxml2 based parser: buffers packets into a string, cuts
+// out whole MetadataStream documents and parses each into a DOM. Kept only
+// as the reference for `--bench parser`.
+class DomMetadataParser {
+private:
+    std::string xml_buffer;
+    std::vector<std::pair<std::string, int64_t>> completed_streams;
+    std::vector<MetadataResult> results;
+    size_t read_ = 0;
+
+    std::vector<Object> extractObj(tinyxml2::XMLElement* element);
+    void processXmlDoc(tinyxml2::XMLDocument& doc, std::vector<Object>& result);
+    void cleanupBuffer();
+    void processCompletedStreams();
+
+public:
+    void processPacket(AVPacket* packet);
+    void processBytes(const uint8_t* data, size_t size, int64_t pts);
+    void processBuffer(int64_t pts);
+    size_t getBufferSize() const;
+    bool popCompletedResult(MetadataResult& result);
+};
+
+#endif // PARSER_DOM_HPP
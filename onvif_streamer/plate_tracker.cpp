@@ -0,0 +1,82 @@
+#include "plate_tracker.hpp"
+
+bool PlateTracker::wantsOcr(int32_t object_id, double now) {
+    Track& track = tracks_[object_id];
+    track.last_seen = now;
+    tracked_ = tracks_.size();
+
+    if (track.settled) {
+        skipped_crops_++;
+        return false;
+    }
+    ocr_crops_++;
+    return true;
+}
+
+void PlateTracker::vote(int32_t object_id, const std::string& label, float confidence,
+                        std::vector<std::string>& reported) {
+    auto it = tracks_.find(object_id);
+    if (it == tracks_.end() || it->second.settled) {
+        return; // expired meanwhile, or settled by an earlier frame still in flight
+    }
+    if (label.empty()) {
+        return;
+    }
+
+    Track& track = it->second;
+    Candidate* candidate = nullptr;
+    for (Candidate& c : track.candidates) {
+        if (c.label == label) {
+            candidate = &c;
+            break;
+        }
+    }
+    if (!candidate) {
+        track.candidates.push_back({label, 0, 0.0f});
+        candidate = &track.candidates.back();
+    }
+    if (confidence > candidate->best_confidence) {
+        candidate->best_confidence = confidence;
+    }
+    // Every read is kept for expiry, only confident ones can settle
+    if (confidence < config_.vote_confidence) {
+        return;
+    }
+    candidate->votes++;
+
+    if (candidate->votes >= config_.votes) {
+        track.settled = true;
+        settled_++;
+        reported.push_back(candidate->label);
+        track.candidates.clear();
+    }
+}
+
+void PlateTracker::expire(double now, std::vector<std::string>& reported) {
+    for (auto it = tracks_.begin(); it != tracks_.end();) {
+        Track& track = it->second;
+        // A timeline jump backwards (stream restart) also expires everything
+        if (now - track.last_seen <= config_.expiry && track.last_seen <= now + config_.expiry) {
+            ++it;
+            continue;
+        }
+
+        if (!track.settled && !track.candidates.empty()) {
+            const Candidate* leader = &track.candidates.front();
+            for (const Candidate& c : track.candidates) {
+                if (c.votes > leader->votes ||
+                    (c.votes == leader->votes && c.best_confidence > leader->best_confidence)) {
+                    leader = &c;
+                }
+            }
+            reported.push_back(leader->label);
+        }
+        expired_++;
+        it = tracks_.erase(it);
+    }
+    tracked_ = tracks_.size();
+}
+
+PlateTrackerStats PlateTracker::stats() const {
+    return {tracked_.load(), settled_.load(), expired_.load(), ocr_crops_.load(), skipped_crops_.load()};
+}
@@ -0,0 +1,76 @@
+#ifndef PLATE_TRACKER_HPP
+#define PLATE_TRACKER_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct PlateTrackerConfig {
+    int votes = 3;                  // agreeing frames that settle an object, 1: first read wins
+    float vote_confidence = 0.5f;   // OCR confidence a read needs to count as a vote
+    double expiry = 1.0;            // seconds an ObjectId may be absent before it is forgotten
+};
+
+struct PlateTrackerStats {
+    size_t tracked;             // live ObjectIds
+    uint64_t settled;           // objects settled by votes
+    uint64_t expired;
+    uint64_t ocr_crops;         // crops of unsettled objects, passed on to OCR (or best-shot selection)
+    uint64_t skipped_crops;     // crops of settled objects, not OCRed
+};
+
+// --- Per-ObjectId OCR cache ---
+// The camera keeps an object's ObjectId while it is in view, so a plate
+// only has to be read until enough frames agree. Every read OCR accepted
+// is kept as a candidate with its best confidence; reads above
+// vote_confidence are also votes for their label. Once one label has
+// `votes` votes the object is settled, its label is reported once and
+// further crops of it are skipped. An object not seen for `expiry` seconds
+// is dropped; if it never settled, its leading label (most votes, then
+// best confidence) is reported then so a briefly visible or weakly read
+// plate is not lost.
+//
+// Single-threaded (the OCR thread); stats() may be called from any thread.
+class PlateTracker {
+public:
+    void configure(const PlateTrackerConfig& config) { config_ = config; }
+
+    // A crop of `object_id` seen at `now` (seconds). Returns false if the
+    // object is settled and the crop need not be OCRed.
+    bool wantsOcr(int32_t object_id, double now);
+    // Record an OCR read; a label settled by it is appended to `reported`
+    void vote(int32_t object_id, const std::string& label, float confidence,
+              std::vector<std::string>& reported);
+    // Forget objects absent since before now - expiry; unsettled leaders are
+    // appended to `reported`
+    void expire(double now, std::vector<std::string>& reported);
+
+    PlateTrackerStats stats() const;
+
+private:
+    struct Candidate {
+        std::string label;
+        int votes;
+        float best_confidence;
+    };
+
+    struct Track {
+        double last_seen = 0.0;
+        bool settled = false;
+        std::vector<Candidate> candidates;
+    };
+
+    PlateTrackerConfig config_;
+    std::unordered_map<int32_t, Track> tracks_;
+
+    std::atomic<size_t> tracked_{0};
+    std::atomic<uint64_t> settled_{0};
+    std::atomic<uint64_t> expired_{0};
+    std::atomic<uint64_t> ocr_crops_{0};
+    std::atomic<uint64_t> skipped_crops_{0};
+};
+
+#endif // PLATE_TRACKER_HPP
@@ -0,0 +1,113 @@
+#include "sharpness.hpp"
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define SHARPNESS_NEON 1
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define SHARPNESS_SSE2 1
+#endif
+
+namespace {
+
+// Pixels per vector pass between flushes of the 32-bit lane sums: each
+// lane takes two squared Laplacians (<= 1020^2) per 8 pixels, so 1024
+// pixels stay far below INT32_MAX
+const int FLUSH_PIXELS = 1024;
+
+inline int laplacian_at(const uint8_t* up, const uint8_t* row, const uint8_t* down, int x) {
+    return 4 * row[x] - row[x - 1] - row[x + 1] - up[x] - down[x];
+}
+
+double variance(int64_t sum, int64_t sum_sq, int64_t count) {
+    double mean = static_cast<double>(sum) / count;
+    return static_cast<double>(sum_sq) / count - mean * mean;
+}
+
+} // namespace
+
+double laplacian_variance_scalar(const uint8_t* luma, int stride, int width, int height) {
+    if (!luma || width < 3 || height < 3) {
+        return 0.0;
+    }
+    int64_t sum = 0;
+    int64_t sum_sq = 0;
+    for (int y = 1; y < height - 1; y++) {
+        const uint8_t* row = luma + y * stride;
+        for (int x = 1; x < width - 1; x++) {
+            int l = laplacian_at(row - stride, row, row + stride, x);
+            sum += l;
+            sum_sq += l * l;
+        }
+    }
+    return variance(sum, sum_sq, static_cast<int64_t>(width - 2) * (height - 2));
+}
+
+double laplacian_variance(const uint8_t* luma, int stride, int width, int height) {
+#if defined(SHARPNESS_NEON) || defined(SHARPNESS_SSE2)
+    if (!luma || width < 3 || height < 3) {
+        return 0.0;
+    }
+    int64_t sum = 0;
+    int64_t sum_sq = 0;
+    for (int y = 1; y < height - 1; y++) {
+        const uint8_t* row = luma + y * stride;
+        const uint8_t* up = row - stride;
+        const uint8_t* down = row + stride;
+        int x = 1;
+
+        // 8 pixels per step; x + 8 may read row[x + 8], so stop one short
+        while (x + 8 < width) {
+            int block_end = x + FLUSH_PIXELS < width - 8 ? x + FLUSH_PIXELS : width - 8;
+#if defined(SHARPNESS_NEON)
+            int32x4_t lane_sum = vdupq_n_s32(0);
+            int32x4_t lane_sq = vdupq_n_s32(0);
+            for (; x < block_end; x += 8) {
+                int16x8_t c = vreinterpretq_s16_u16(vmovl_u8(vld1_u8(row + x)));
+                int16x8_t l = vreinterpretq_s16_u16(vmovl_u8(vld1_u8(row + x - 1)));
+                int16x8_t r = vreinterpretq_s16_u16(vmovl_u8(vld1_u8(row + x + 1)));
+                int16x8_t u = vreinterpretq_s16_u16(vmovl_u8(vld1_u8(up + x)));
+                int16x8_t d = vreinterpretq_s16_u16(vmovl_u8(vld1_u8(down + x)));
+                int16x8_t lap = vsubq_s16(vshlq_n_s16(c, 2), vaddq_s16(vaddq_s16(l, r), vaddq_s16(u, d)));
+                lane_sum = vpadalq_s16(lane_sum, lap);
+                lane_sq = vmlal_s16(lane_sq, vget_low_s16(lap), vget_low_s16(lap));
+                lane_sq = vmlal_s16(lane_sq, vget_high_s16(lap), vget_high_s16(lap));
+            }
+            int32_t sums[4], squares[4];
+            vst1q_s32(sums, lane_sum);
+            vst1q_s32(squares, lane_sq);
+#else
+            const __m128i zero = _mm_setzero_si128();
+            const __m128i ones = _mm_set1_epi16(1);
+            __m128i lane_sum = zero;
+            __m128i lane_sq = zero;
+            for (; x < block_end; x += 8) {
+                __m128i c = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(row + x)), zero);
+                __m128i l = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(row + x - 1)), zero);
+                __m128i r = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(row + x + 1)), zero);
+                __m128i u = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(up + x)), zero);
+                __m128i d = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(down + x)), zero);
+                __m128i lap = _mm_sub_epi16(_mm_slli_epi16(c, 2),
+                                            _mm_add_epi16(_mm_add_epi16(l, r), _mm_add_epi16(u, d)));
+                lane_sum = _mm_add_epi32(lane_sum, _mm_madd_epi16(lap, ones));
+                lane_sq = _mm_add_epi32(lane_sq, _mm_madd_epi16(lap, lap));
+            }
+            alignas(16) int32_t sums[4], squares[4];
+            _mm_store_si128(reinterpret_cast<__m128i*>(sums), lane_sum);
+            _mm_store_si128(reinterpret_cast<__m128i*>(squares), lane_sq);
+#endif
+            sum += static_cast<int64_t>(sums[0]) + sums[1] + sums[2] + sums[3];
+            sum_sq += static_cast<int64_t>(squares[0]) + squares[1] + squares[2] + squares[3];
+        }
+
+        for (; x < width - 1; x++) {
+            int l = laplacian_at(up, row, down, x);
+            sum += l;
+            sum_sq += l * l;
+        }
+    }
+    return variance(sum, sum_sq, static_cast<int64_t>(width - 2) * (height - 2));
+#else
+    return laplacian_variance_scalar(luma, stride, width, height);
+#endif
+}
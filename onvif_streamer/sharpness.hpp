@@ -0,0 +1,14 @@
+#ifndef SHARPNESS_HPP
+#define SHARPNESS_HPP
+
+#include <cstdint>
+
+// Variance of the 4-neighbour Laplacian over the interior of an 8-bit luma
+// plane, a cheap focus/motion-blur measure: sharp plate characters give
+// strong second derivatives, blurred ones do not. Planes smaller than 3x3
+// score 0. Uses NEON or SSE2 when the build targets them; the result is
+// identical to the scalar version (integer accumulation).
+double laplacian_variance(const uint8_t* luma, int stride, int width, int height);
+double laplacian_variance_scalar(const uint8_t* luma, int stride, int width, int height);
+
+#endif // SHARPNESS_HPP
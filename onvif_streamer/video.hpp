@@ -1,54 +1,65 @@
 #ifndef VIDEO_HPP
 #define VIDEO_HPP
 
-extern "C" { 
+extern "C" {
 #include <libavformat/avformat.h>
 #include <libavcodec/avcodec.h>
 #include <libavutil/frame.h>
-#include <libavutil/imgutils.h>
 #include <libavutil/avutil.h>
-#include <libswscale/swscale.h>
 }
 
-#include <opencv2/opencv.hpp>
 #include <iostream>
 
-#include "parser.hpp"
+#include "frame_pool.hpp"
 
+// Decoder tuning, kept in one place
+struct DecoderConfig {
+    int thread_count = 0;                                   // 0: auto-detect
+    int thread_type = FF_THREAD_FRAME | FF_THREAD_SLICE;
+    int max_consecutive_errors = 10;                        // flush and wait for a keyframe after this many
+};
 
+// The single H.264 decode engine of the pipeline.
+// Packets go in with sendPacket(), refcounted frames come out of
+// receiveFrame(). Keyframe resync and error recovery are handled here.
 class VideoProcessor {
     private:
+        DecoderBufferPool buffer_pool_;   // outlives codec_context_
         AVCodecContext* codec_context_;
         const AVCodec* codec_;
-        AVFrame* frame_;
         bool initialized_;
+        DecoderConfig config_;
 
-        AVBufferRef* hw_device_ctx_;
-        SwsContext* sws_ctx_;
-        std::vector<cv::Mat> cropped_images_; // Store cropped images
-        
-        // Post-processing for deblocking
-        struct SwsContext* pp_sws_ctx_;
-        AVFrame* pp_frame_;
+        // Frame reference tracking for I/P frame handling
+        bool need_keyframe_;
+        int consecutive_errors_;
 
         int width_;
         int height_;
-        const double ORIGINAL_WIDTH = 3840.0;   // source resolution width
-        const double ORIGINAL_HEIGHT = 2160.0;  // source resolution height
-
-        void cropDetectionBoxes(AVFrame* frame, std::vector<Object>& objects, cv::Point2f user_point = cv::Point2f(1920.0, 1080.0));
-        cv::Mat yuv420_to_mat(AVFrame* frame, int x, int y, int width, int height);
-        cv::Mat frame_to_mat(AVFrame* frame); // Convert full frame to OpenCV Mat
 
     public:
         VideoProcessor();
         ~VideoProcessor();
-        bool initialize(AVCodecParameters* codecpar);
+        bool initialize(AVCodecParameters* codecpar, const DecoderConfig& config = DecoderConfig());
+
+        // Returns false if the packet was skipped (waiting for a keyframe) or rejected
+        bool sendPacket(const AVPacket* pkt);
+        // Moves the next decoded frame into `frame` (a new reference). Returns false
+        // when the decoder needs more input.
+        bool receiveFrame(AVFrame* frame);
+
+        // Drop input until the next keyframe, e.g. after upstream packet loss
+        void requestKeyframe() { need_keyframe_ = true; }
+        // Discard everything buffered inside the decoder
         void flush();
-        std::vector<cv::Mat> processFrameForCropping(AVPacket* pkt, std::vector<Object>& objects);
-        cv::Mat processFrameForDisplay(AVPacket* pkt); // Process frame for full display
-        std::vector<cv::Mat> getCroppedImages() const { return cropped_images_; };
+        // Frames the decoder may skip (AVDISCARD_NONE decodes everything)
+        void setSkipFrame(AVDiscard discard);
+
+        BufferPoolStats bufferPoolStats() const { return buffer_pool_.stats(); }
+
+        int width() const { return width_; }
+        int height() const { return height_; }
 };
 
 
-#endif // VIDEO_HPP
\ No newline at end of file
+#endif // VIDEO_HPP
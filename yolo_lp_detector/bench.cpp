@@ -0,0 +1,422 @@
+#include "bench.hpp"
+#include "yolo.hpp"
+#include "proposals.hpp"
+#include "postprocess.hpp"
+#include "motion_gate.hpp"
+#include "ocr_bench.hpp"
+
+#include <opencv2/core.hpp>
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/imgproc.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+using bench_clock = std::chrono::steady_clock;
+
+std::vector<YoloOutput> load_captures(const std::string& dir) {
+    std::vector<cv::String> files;
+    cv::glob(dir + "/*.yolo", files, false);
+    std::sort(files.begin(), files.end());
+
+    std::vector<YoloOutput> captures;
+    for (const cv::String& file : files) {
+        YoloOutput output;
+        if (load_yolo_output(file, output)) {
+            captures.push_back(output);
+        } else {
+            std::cerr << "[BENCH] Skipping unreadable capture " << file << std::endl;
+        }
+    }
+    return captures;
+}
+
+bool same_objects(const std::vector<Object>& a, const Proposals& b) {
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.size(); ++i) {
+        Object o = b.object(i);
+        if (a[i].label != o.label || a[i].prob != o.prob || a[i].rect != o.rect) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool same_objects(const std::vector<Object>& a, const std::vector<Object>& b) {
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (a[i].label != b[i].label || a[i].prob != b[i].prob || a[i].rect != b[i].rect) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Same detections, ignoring the order among exactly equal scores (the
+// former quicksort leaves ties in an arbitrary order)
+bool same_detections(std::vector<Object> a, std::vector<Object> b) {
+    auto canonical = [](const Object& l, const Object& r) {
+        if (l.prob != r.prob) return l.prob > r.prob;
+        if (l.rect.x != r.rect.x) return l.rect.x < r.rect.x;
+        if (l.rect.y != r.rect.y) return l.rect.y < r.rect.y;
+        if (l.rect.width != r.rect.width) return l.rect.width < r.rect.width;
+        if (l.rect.height != r.rect.height) return l.rect.height < r.rect.height;
+        return l.label < r.label;
+    };
+    std::sort(a.begin(), a.end(), canonical);
+    std::sort(b.begin(), b.end(), canonical);
+    return same_objects(a, b);
+}
+
+// --bench capture <image_dir> <out_dir> [target_size] : save the head
+// outputs of every image as <out_dir>/<n>.yolo
+int bench_capture(int argc, char* argv[], const YoloEngineConfig& engine_config) {
+    if (argc < 2) {
+        std::cerr << "Usage: lp_detect --bench capture <image_dir> <out_dir> [target_size]" << std::endl;
+        return 1;
+    }
+    int target_size = argc > 2 ? atoi(argv[2]) : 640;
+    std::vector<cv::Mat> images = load_crop_images(argv[0]);
+    if (images.empty()) {
+        std::cerr << "[BENCH] No images in " << argv[0] << std::endl;
+        return 1;
+    }
+
+    Yolo yolo;
+    yolo.load("lp_detect_v5n.ncnn.param", "lp_detect_v5n.ncnn.bin", engine_config);
+    for (size_t i = 0; i < images.size(); ++i) {
+        YoloOutput output;
+        yolo.forward(images[i], target_size, output);
+        char name[32];
+        snprintf(name, sizeof(name), "/%04zu.yolo", i);
+        if (!save_yolo_output(argv[1] + std::string(name), output)) {
+            std::cerr << "[BENCH] Failed to write " << argv[1] << name << std::endl;
+            return 1;
+        }
+    }
+    std::cout << "[BENCH] capture: " << images.size() << " frames written to " << argv[1] << std::endl;
+    return 0;
+}
+
+// --bench proposals <capture_dir> [prob_threshold] [iterations] : early-
+// reject SIMD decoder vs the former per-cell decoder on captured outputs
+int bench_proposals(int argc, char* argv[]) {
+    if (argc < 1) {
+        std::cerr << "Usage: lp_detect --bench proposals <capture_dir> [prob_threshold] [iterations]" << std::endl;
+        return 1;
+    }
+    float prob_threshold = argc > 1 ? static_cast<float>(atof(argv[1])) : 0.25f;
+    int iterations = argc > 2 ? atoi(argv[2]) : 100;
+    std::vector<YoloOutput> captures = load_captures(argv[0]);
+    if (captures.empty()) {
+        std::cerr << "[BENCH] No .yolo captures in " << argv[0] << " (see --bench capture)" << std::endl;
+        return 1;
+    }
+
+    size_t cells = 0;
+    size_t proposals = 0;
+    size_t mismatches = 0;
+    std::vector<Object> reference;
+    Proposals fast;
+    for (const YoloOutput& capture : captures) {
+        for (int s = 0; s < 3; ++s) {
+            const ncnn::Mat& blob = capture.out[s];
+            cells += static_cast<size_t>(blob.w) * blob.h * 3;
+            reference.clear();
+            fast.clear();
+            generate_proposals_reference(YOLO_ANCHORS[s], 3, YOLO_STRIDES[s], blob, prob_threshold, reference);
+            generate_proposals(YOLO_ANCHORS[s], 3, YOLO_STRIDES[s], blob, prob_threshold, fast);
+            proposals += reference.size();
+            if (!same_objects(reference, fast)) {
+                mismatches++;
+            }
+        }
+    }
+
+    std::vector<double> reference_ms;
+    std::vector<double> fast_ms;
+    for (int it = 0; it < iterations; ++it) {
+        for (const YoloOutput& capture : captures) {
+            auto start = bench_clock::now();
+            reference.clear();
+            for (int s = 0; s < 3; ++s) {
+                generate_proposals_reference(YOLO_ANCHORS[s], 3, YOLO_STRIDES[s], capture.out[s], prob_threshold, reference);
+            }
+            reference_ms.push_back(std::chrono::duration<double, std::milli>(bench_clock::now() - start).count());
+
+            start = bench_clock::now();
+            fast.clear();
+            for (int s = 0; s < 3; ++s) {
+                generate_proposals(YOLO_ANCHORS[s], 3, YOLO_STRIDES[s], capture.out[s], prob_threshold, fast);
+            }
+            fast_ms.push_back(std::chrono::duration<double, std::milli>(bench_clock::now() - start).count());
+        }
+    }
+
+    std::cout << "[BENCH] proposals: " << captures.size() << " frames, " << iterations << " iterations, "
+              << "prob_threshold " << prob_threshold << ", "
+              << cells / captures.size() << " anchor cells/frame, "
+              << static_cast<double>(proposals) / captures.size() << " proposals/frame" << std::endl;
+    LatencySummary reference_summary = summarize_latency(reference_ms);
+    LatencySummary fast_summary = summarize_latency(fast_ms);
+    print_latency("reference", reference_summary);
+    print_latency("early-reject", fast_summary);
+    std::cout << "  speedup: " << (fast_summary.mean_ms > 0.0 ? reference_summary.mean_ms / fast_summary.mean_ms : 0.0)
+              << "x, mismatches: " << mismatches << std::endl;
+    return mismatches == 0 ? 0 : 2;
+}
+
+// --bench postprocess <capture_dir> [prob_threshold] [nms_threshold] [iterations] [max_candidates] :
+// decode + top-k + grid NMS vs the former decode + quicksort + all-pairs NMS;
+// the captures are the regression corpus, detections must be identical
+int bench_postprocess(int argc, char* argv[]) {
+    if (argc < 1) {
+        std::cerr << "Usage: lp_detect --bench postprocess <capture_dir> [prob_threshold] [nms_threshold] "
+                     "[iterations] [max_candidates]" << std::endl;
+        return 1;
+    }
+    float prob_threshold = argc > 1 ? static_cast<float>(atof(argv[1])) : 0.25f;
+    float nms_threshold = argc > 2 ? static_cast<float>(atof(argv[2])) : 0.45f;
+    int iterations = argc > 3 ? atoi(argv[3]) : 100;
+    std::vector<YoloOutput> captures = load_captures(argv[0]);
+    if (captures.empty()) {
+        std::cerr << "[BENCH] No .yolo captures in " << argv[0] << " (see --bench capture)" << std::endl;
+        return 1;
+    }
+
+    YoloPostprocess postprocess;
+    if (argc > 4) {
+        postprocess.nms().setMaxCandidates(static_cast<size_t>(atoi(argv[4])));
+    }
+
+    size_t detections = 0;
+    size_t truncated_frames = 0;
+    size_t mismatches = 0;
+    std::vector<Object> reference;
+    std::vector<Object> fast;
+    for (const YoloOutput& capture : captures) {
+        yolo_postprocess_reference(capture, prob_threshold, nms_threshold, reference);
+        postprocess.run(capture, prob_threshold, nms_threshold, fast);
+        detections += reference.size();
+        truncated_frames += postprocess.nms().truncated() > 0;
+        if (!same_detections(reference, fast)) {
+            mismatches++;
+        }
+    }
+
+    std::vector<double> reference_ms;
+    std::vector<double> fast_ms;
+    for (int it = 0; it < iterations; ++it) {
+        for (const YoloOutput& capture : captures) {
+            auto start = bench_clock::now();
+            yolo_postprocess_reference(capture, prob_threshold, nms_threshold, reference);
+            reference_ms.push_back(std::chrono::duration<double, std::milli>(bench_clock::now() - start).count());
+
+            start = bench_clock::now();
+            postprocess.run(capture, prob_threshold, nms_threshold, fast);
+            fast_ms.push_back(std::chrono::duration<double, std::milli>(bench_clock::now() - start).count());
+        }
+    }
+
+    std::cout << "[BENCH] postprocess: " << captures.size() << " frames, " << iterations << " iterations, "
+              << "prob " << prob_threshold << " nms " << nms_threshold << ", "
+              << static_cast<double>(detections) / captures.size() << " detections/frame, "
+              << truncated_frames << " frames over the top-k cap" << std::endl;
+    LatencySummary reference_summary = summarize_latency(reference_ms);
+    LatencySummary fast_summary = summarize_latency(fast_ms);
+    print_latency("qsort+nms", reference_summary);
+    print_latency("topk+grid", fast_summary);
+    std::cout << "  speedup: " << (fast_summary.mean_ms > 0.0 ? reference_summary.mean_ms / fast_summary.mean_ms : 0.0)
+              << "x, frames with different detections: " << mismatches << std::endl;
+    return mismatches == 0 ? 0 : 2;
+}
+
+// --bench detect <frame_dir> [iterations] [target_size] : detect() latency
+// with the --yolo-config options, then with each option changed on its own
+int bench_detect(int argc, char* argv[], const YoloEngineConfig& engine_config) {
+    if (argc < 1) {
+        std::cerr << "Usage: lp_detect --bench detect <frame_dir> [iterations] [target_size]" << std::endl;
+        return 1;
+    }
+    int iterations = argc > 1 ? atoi(argv[1]) : 5;
+    int target_size = argc > 2 ? atoi(argv[2]) : 640;
+    std::vector<cv::Mat> frames = load_crop_images(argv[0]);
+    if (frames.empty()) {
+        std::cerr << "[BENCH] No images in " << argv[0] << std::endl;
+        return 1;
+    }
+
+    struct Variant {
+        std::string name;
+        YoloEngineConfig config;
+    };
+    std::vector<Variant> variants;
+    variants.push_back({"config", engine_config});
+    auto toggled = [&](const std::string& name, bool YoloEngineConfig::*option) {
+        YoloEngineConfig config = engine_config;
+        config.*option = !(config.*option);
+        variants.push_back({name + (config.*option ? "=on" : "=off"), config});
+    };
+    toggled("fp16_storage", &YoloEngineConfig::use_fp16_storage);
+    toggled("fp16_arithmetic", &YoloEngineConfig::use_fp16_arithmetic);
+    toggled("packing", &YoloEngineConfig::use_packing_layout);
+    toggled("lightmode", &YoloEngineConfig::lightmode);
+    toggled("winograd", &YoloEngineConfig::use_winograd_convolution);
+    toggled("pools", &YoloEngineConfig::pool_allocators);
+    for (int threads : {1, 2, 4}) {
+        if (threads != engine_config.num_threads) {
+            YoloEngineConfig config = engine_config;
+            config.num_threads = threads;
+            variants.push_back({"threads=" + std::to_string(threads), config});
+        }
+    }
+
+    std::cout << "[BENCH] detect: " << frames.size() << " frames, " << iterations << " iterations, target "
+              << target_size << ", config " << describe_yolo_engine_config(engine_config) << std::endl;
+
+    double config_mean_ms = 0.0;
+    std::vector<Object> objects;
+    for (const Variant& variant : variants) {
+        Yolo yolo;
+        yolo.load("lp_detect_v5n.ncnn.param", "lp_detect_v5n.ncnn.bin", variant.config);
+
+        // Warm-up pass: first inference packs weights and fills the pools
+        size_t detections = 0;
+        for (const cv::Mat& frame : frames) {
+            yolo.detect(frame, objects, target_size, 0.25f, 0.45f);
+            detections += objects.size();
+        }
+
+        std::vector<double> latency_ms;
+        for (int it = 0; it < iterations; ++it) {
+            for (const cv::Mat& frame : frames) {
+                auto start = bench_clock::now();
+                yolo.detect(frame, objects, target_size, 0.25f, 0.45f);
+                latency_ms.push_back(std::chrono::duration<double, std::milli>(bench_clock::now() - start).count());
+            }
+        }
+
+        LatencySummary summary = summarize_latency(latency_ms);
+        if (variant.name == "config") {
+            config_mean_ms = summary.mean_ms;
+        }
+        print_latency(variant.name.c_str(), summary);
+        std::cout << "    " << static_cast<double>(detections) / frames.size() << " detections/frame";
+        if (config_mean_ms > 0.0 && variant.name != "config") {
+            std::cout << ", " << summary.mean_ms / config_mean_ms << "x of config";
+        }
+        std::cout << std::endl;
+    }
+    return 0;
+}
+
+// --bench motion <frame_dir> [interval_ms] [block_threshold] : run the motion
+// gate over a recorded sequence (frames in name order, `interval_ms` apart)
+// and report how many detections it skips; the SIMD tile SAD must match the
+// scalar one on every consecutive pair
+int bench_motion(int argc, char* argv[]) {
+    if (argc < 1) {
+        std::cerr << "Usage: lp_detect --bench motion <frame_dir> [interval_ms] [block_threshold]" << std::endl;
+        return 1;
+    }
+    int interval_ms = argc > 1 ? atoi(argv[1]) : 40;
+    std::vector<cv::Mat> frames = load_crop_images(argv[0]);
+    if (frames.empty()) {
+        std::cerr << "[BENCH] No images in " << argv[0] << std::endl;
+        return 1;
+    }
+
+    MotionGateConfig config;
+    if (argc > 2) {
+        config.block_threshold = atoi(argv[2]);
+    }
+    MotionGate gate;
+    gate.configure(config);
+
+    // SIMD vs scalar on the downscaled planes of consecutive frames
+    size_t mismatches = 0;
+    std::vector<double> simd_ms;
+    std::vector<double> scalar_ms;
+    std::vector<uint32_t> simd_sad;
+    std::vector<uint32_t> scalar_sad;
+    cv::Mat previous;
+    for (const cv::Mat& frame : frames) {
+        cv::Mat small;
+        cv::Mat luma;
+        cv::resize(frame, small, cv::Size(frame.cols / config.scale, frame.rows / config.scale), 0, 0, cv::INTER_AREA);
+        cv::cvtColor(small, luma, cv::COLOR_BGR2GRAY);
+        if (!previous.empty() && previous.size() == luma.size()) {
+            auto start = bench_clock::now();
+            block_sad(luma.data, previous.data, static_cast<int>(luma.step), luma.cols, luma.rows,
+                      config.block_size, simd_sad);
+            simd_ms.push_back(std::chrono::duration<double, std::milli>(bench_clock::now() - start).count());
+            start = bench_clock::now();
+            block_sad_scalar(luma.data, previous.data, static_cast<int>(luma.step), luma.cols, luma.rows,
+                             config.block_size, scalar_sad);
+            scalar_ms.push_back(std::chrono::duration<double, std::milli>(bench_clock::now() - start).count());
+            if (simd_sad != scalar_sad) {
+                mismatches++;
+            }
+        }
+        previous = luma;
+    }
+
+    // Gate decisions with simulated frame times; detections are not run, so
+    // the hold after plates were seen does not apply here
+    std::vector<double> gate_ms;
+    MotionGate::Clock::time_point now{};
+    for (const cv::Mat& frame : frames) {
+        auto start = bench_clock::now();
+        gate.check(frame, now);
+        gate_ms.push_back(std::chrono::duration<double, std::milli>(bench_clock::now() - start).count());
+        now += std::chrono::milliseconds(interval_ms);
+    }
+
+    MotionGateStats stats = gate.stats();
+    std::cout << "[BENCH] motion: " << frames.size() << " frames, " << interval_ms << " ms apart, threshold "
+              << config.block_threshold << ", refresh " << config.refresh_ms << " ms" << std::endl;
+    std::cout << "  motion " << stats.motion << " refresh " << stats.refresh << " skipped " << stats.skipped
+              << " (" << (stats.frames ? 100.0 * stats.skipped / stats.frames : 0.0) << "% skipped)" << std::endl;
+    print_latency("gate      ", summarize_latency(gate_ms));
+    print_latency("sad simd  ", summarize_latency(simd_ms));
+    print_latency("sad scalar", summarize_latency(scalar_ms));
+    std::cout << "  frame pairs with different tile SADs: " << mismatches << std::endl;
+    return mismatches == 0 ? 0 : 2;
+}
+
+} // namespace
+
+int run_bench(int argc, char* argv[], const YoloEngineConfig& engine_config) {
+    if (argc < 1) {
+        std::cerr << "Usage: --bench ocr|ctc|detect|motion|capture|proposals|postprocess ..." << std::endl;
+        return 1;
+    }
+    if (strcmp(argv[0], "motion") == 0) {
+        return bench_motion(argc - 1, argv + 1);
+    }
+    if (strcmp(argv[0], "detect") == 0) {
+        return bench_detect(argc - 1, argv + 1, engine_config);
+    }
+    if (strcmp(argv[0], "capture") == 0) {
+        return bench_capture(argc - 1, argv + 1, engine_config);
+    }
+    if (strcmp(argv[0], "proposals") == 0) {
+        return bench_proposals(argc - 1, argv + 1);
+    }
+    if (strcmp(argv[0], "postprocess") == 0) {
+        return bench_postprocess(argc - 1, argv + 1);
+    }
+    std::cerr << "Unknown benchmark: " << argv[0] << std::endl;
+    return 1;
+}
@@ -0,0 +1,11 @@
+#ifndef BENCH_HPP
+#define BENCH_HPP
+
+#include "yolo_engine.hpp"
+
+// Detector benchmarks on recorded frames and captured head outputs, run as
+// `lp_detect --bench <name> ...`; `engine_config` is the ncnn setup from
+// --yolo-config. Returns the process exit code.
+int run_bench(int argc, char* argv[], const YoloEngineConfig& engine_config);
+
+#endif // BENCH_HPP
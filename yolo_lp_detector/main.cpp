@@ -14,11 +14,23 @@
 #include <vector>                     // std::vector
 #include <iostream>                   // std::cout
 #include <chrono>                     // std::chrono
+#include <cstring>                    // strcmp, strerror
+#include <string>                     // std::string
+#include <algorithm>                  // std::max
+#include <csignal>                    // SIGUSR1: 강제 검출
 
 #include "yolo.hpp"                   // Yolo 클래스 정의
 #include "plate.hpp"
 #include "tf_ocr.hpp"                 // TFOCR 클래스 정의
 #include "json.hpp"                   // JSON 라이브러리
+#include "ocr_engine.hpp"             // OCR 실행 백엔드 설정
+#include "ocr_bench.hpp"              // --bench ocr, --bench ctc
+#include "bench.hpp"                  // --bench detect, capture, proposals, postprocess
+#include "yolo_engine.hpp"            // ncnn 실행 옵션 설정
+#include "debug_recorder.hpp"         // 샘플링된 디버그 이미지 기록
+#include "spsc_ring.hpp"              // 단계 사이의 고정 용량 큐
+#include "event_notifier.hpp"         // 단계 스레드 wakeup
+#include "motion_gate.hpp"            // 정적 장면에서 YOLO 생략
 
 using json = nlohmann::json;
 
@@ -37,11 +49,11 @@ const size_t SHM_CONFIG_SIZE = 4096; // 4KB
 const char* SHM_SEQUENCE_NAME = "/busbom_sequence";
 const size_t SHM_SEQUENCE_SIZE = 4096; // 4KB
 
-// For OCR processing
-struct OcrInput {
-    cv::Mat image;
-    int index;
-};
+// OCR execution backend, from ocr_engine.json or --ocr-config
+OcrEngineConfig ocr_engine_config;
+
+// ncnn runtime options of the detector, from yolo_engine.json or --yolo-config
+YoloEngineConfig yolo_engine_config;
 
 // 공유 메모리에서 프레임을 읽어 큐에 삽입
 void reader_thread()
@@ -69,70 +81,180 @@ void reader_thread()
 }
 
 
-void inference_thread()
-{
-    Yolo yolo;
-    yolo.load("lp_detect_v5n.ncnn.param", "lp_detect_v5n.ncnn.bin");  
-    std::cout << "Model loaded successfully." << std::endl;
-    
-    std::cout << "Inference thread started." << std::endl;
+// --- Inference pipeline ---
+// detect_thread -> detected_queue -> prep_thread -> prepared_queue -> ocr_thread
+// Each stage runs on its own thread, so YOLO on frame N+1 overlaps plate
+// preprocessing and OCR of frame N. The queues are short and block the
+// upstream stage briefly when full (frames are already dropped oldest-first
+// at img_queue, so a stalled OCR slows detection down instead of piling up
+// stale frames).
 
-    TFOCR ocr;  
-    ocr.load_ocr("model.tflite", "labels.names");  // Load OCR model and labels
-    std::cout << "OCR model loaded successfully." << std::endl;
+// One detection result, handed from detect to prep
+struct DetectedFrame {
+    cv::Mat frame;
+    std::vector<Object> objects;
+};
 
-    PlatePrep plate_prep;  // Create PlateOCR instance
-    std::cout << "PlateOCR instance created." << std::endl;
+// Objects sorted by distance from the frame center, and their preprocessed
+// plates (plates[i] belongs to objects[i], empty if preprocessing failed)
+struct PreparedFrame {
+    cv::Mat frame;
+    std::vector<Object> objects;
+    std::vector<cv::Mat> plates;
+};
+
+SpscRing<DetectedFrame> detected_queue(2, OverflowPolicy::BlockWithTimeout, std::chrono::milliseconds(200));
+SpscRing<PreparedFrame> prepared_queue(2, OverflowPolicy::BlockWithTimeout, std::chrono::milliseconds(200));
+EventNotifier prep_wakeup;
+EventNotifier ocr_wakeup;
+const std::chrono::milliseconds WAKEUP_TIMEOUT(100);
+
+// Detector shared by the stages: detect_thread runs the network, the other
+// stages only use the helpers that do not touch it (crop, distance, drawing)
+Yolo yolo;
+
+// Latency samples of one stage since the last report
+class StageLatency {
+public:
+    void add(std::chrono::steady_clock::time_point start) {
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        std::lock_guard<std::mutex> lock(mutex_);
+        samples_.push_back(ms);
+    }
+
+    std::vector<double> take() {
+        std::vector<double> samples;
+        std::lock_guard<std::mutex> lock(mutex_);
+        samples.swap(samples_);
+        return samples;
+    }
+
+private:
+    std::mutex mutex_;
+    std::vector<double> samples_;
+};
+
+StageLatency gate_latency;
+StageLatency detect_latency;
+StageLatency prep_latency;
+StageLatency ocr_latency;
+
+// Skips detection while the bus bay does not change; see --motion-* options.
+// SIGUSR1 forces the next frame through.
+MotionGate motion_gate;
+
+void force_detection(int)
+{
+    motion_gate.force_next();
+}
+
+// Stage 1: frame -> motion gate -> yolo.detect() -> objects[]
+void detect_thread()
+{
+    std::cout << "Detect stage started." << std::endl;
+    DetectedFrame detected;
 
     while (true)
     {
-
-        // objects : {cv::Rect_<float> rect; int label; float prob;}
-        // frame : cv::Mat
         cv::Mat frame;
-        std::vector<Object> objects;  
         {
             std::unique_lock<std::mutex> lock(mtx);
             cvn.wait(lock, []{ return !img_queue.empty(); });   // 데이터 올 때까지 대기
-            frame = img_queue.front();                        
+            frame = img_queue.front();
             img_queue.pop();                                    // 큐에서 제거
         }
-        int w_center = frame.cols / 2; // 프레임 중앙 x 좌표
-        int h_center = frame.rows / 2; // 프레임 중앙 y 좌표
-        cv::Point2f center = cv::Point2f(w_center, h_center);  
-        
-        auto t1 = std::chrono::high_resolution_clock::now();
-        // frame -> yolo.detect() -> objects[]
-        yolo.detect(frame, objects, 640, 0.25f, 0.45f);                     // 추론 수행
-        auto t2 = std::chrono::high_resolution_clock::now();
-        auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(t2 - t1).count();
-        std::cout << "[MAIN] yolo.detect() latency: " << ms << " ms" << std::endl;
-
-        // frame, objects -> yolo.crop_objects() -> cropped[]
-        // cropped license plate images from objects & frame
-        std::vector<cv::Mat> cropped = yolo.crop_objects(frame, objects);   // 결과 객체 크롭
-
-        // frame, objects, point -> yolo.calc_distance() -> objects[]
-        // calculate distance from center point to each detected object, sort by distance
-        // and draw lines from center to each object (-> drawed on frame)
+
+        // Static scene: the last published result still holds
+        auto start = std::chrono::steady_clock::now();
+        MotionDecision decision = motion_gate.check(frame, start);
+        gate_latency.add(start);
+        if (decision == MotionDecision::Skip) continue;
+
+        start = std::chrono::steady_clock::now();
+        // objects : {cv::Rect_<float> rect; int label; float prob;}
+        yolo.detect(frame, detected.objects, 640, 0.25f, 0.45f);          // 추론 수행
+        detect_latency.add(start);
+        motion_gate.report(detected.objects.size(), std::chrono::steady_clock::now());
+
+        detected.frame = frame;
+        detected_queue.push(detected);
+    }
+}
+
+// Stage 2: crop, sort by distance, plate preprocessing
+void prep_thread()
+{
+    PlatePrep plate_prep;  // Create PlateOCR instance
+    std::cout << "Prep stage started." << std::endl;
+    DetectedFrame detected;
+    PreparedFrame prepared;
+
+    while (true)
+    {
+        uint64_t wake_key = prep_wakeup.prepare_wait();
+        if (!detected_queue.try_pop(detected)) {
+            prep_wakeup.wait(wake_key, WAKEUP_TIMEOUT);
+            continue;
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        cv::Point2f center = cv::Point2f(detected.frame.cols / 2, detected.frame.rows / 2);  // 프레임 중앙
+
+        // sort objects by distance from the center first, so the crops below
+        // (plates[i]) follow the final order of objects[]
         // objects[] will be updated with distance in prob field
-        yolo.calc_distance(objects, center, frame); 
+        yolo.sort_by_distance(detected.objects, center);
 
+        // cropped license plate images from objects & frame, taken before
+        // anything is drawn on the frame
+        std::vector<cv::Mat> cropped = yolo.crop_objects(detected.frame, detected.objects);   // 결과 객체 크롭
+
+        prepared.plates.resize(cropped.size());
         for (size_t i = 0; i < cropped.size(); ++i)
         {
-            cv::Mat preprocessed_plate = plate_prep.preprocess_plate(cropped[i], i); // 전처리
-            if (preprocessed_plate.empty()) continue;  // 전처리 실패 시 건너뛰기
-            
-            OcrInput ocr_input;
-            ocr_input.image = preprocessed_plate;
-            ocr_input.index = i;
-
-            std::string each_result = ocr.run_ocr(preprocessed_plate); // OCR 실행
+            prepared.plates[i] = cropped[i].empty() ? cv::Mat() : plate_prep.preprocess_plate(cropped[i], i); // 전처리
+        }
+
+        // draw lines from center to each object (-> drawed on frame)
+        yolo.draw_distance(detected.objects, center, detected.frame);
+
+        prepared.frame = detected.frame;
+        prepared.objects.swap(detected.objects);
+        prep_latency.add(start);
+
+        prepared_queue.push(prepared);
+    }
+}
+
+// Stage 3: OCR, JSON to shared memory, sampled result image
+void ocr_thread()
+{
+    TFOCR ocr;
+    ocr.load_ocr("model.tflite", "labels.names", ocr_engine_config);  // Load OCR model and labels
+    std::cout << "OCR model loaded successfully." << std::endl;
+
+    const DebugTag result_tag = debug_recorder().tag("result");
+    PreparedFrame prepared;
+
+    while (true)
+    {
+        uint64_t wake_key = ocr_wakeup.prepare_wait();
+        if (!prepared_queue.try_pop(prepared)) {
+            ocr_wakeup.wait(wake_key, WAKEUP_TIMEOUT);
+            continue;
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        std::vector<Object>& objects = prepared.objects;
+        for (size_t i = 0; i < prepared.plates.size(); ++i)
+        {
+            if (prepared.plates[i].empty()) continue;  // 전처리 실패 시 건너뛰기
+
+            std::string each_result = ocr.run_ocr(prepared.plates[i]); // OCR 실행
             std::cout << "OCR Result for index " << i << ": " << each_result << std::endl;
             objects[i].ocr_result = each_result; // OCR 결과 저장
-
         }
-        
+
         // Create JSON object from 'objects' and write to shared memory
         json json_objects = json::array();
         for (size_t i = 0; i < objects.size(); ++i) {
@@ -164,21 +286,148 @@ void inference_thread()
             }
             close(shm_fd);
         }
-        
-        // frame, objects -> yolo.draw_result() -> one_shot
-        cv::Mat one_shot = yolo.draw_result(frame, objects);                // 결과 이미지에 그리기
-        cv::imwrite("result.jpg", one_shot); // 결과 이미지 저장
-        
+        ocr_latency.add(start);
+
+        // frame, objects -> yolo.draw_result() -> one_shot (샘플링된 프레임만)
+        if (debug_recorder().sample(result_tag)) {
+            cv::Mat one_shot = yolo.draw_result(prepared.frame, objects);   // 결과 이미지에 그리기
+            debug_recorder().record(result_tag, one_shot, "result.jpg");   // 기록 스레드가 저장
+        }
     }
 }
 
+void print_queue_stats(const char* name, const QueueStats& stats)
+{
+    std::cout << "[STATS] " << name
+              << " occupancy " << stats.occupancy << "/" << stats.capacity
+              << " (peak " << stats.high_watermark << ")"
+              << " pushed " << stats.pushed
+              << " popped " << stats.popped
+              << " dropped " << stats.dropped_newest
+              << " timeouts " << stats.timeouts << std::endl;
+}
 
-int main()
+// Periodically report per-stage latency and queue depth
+void stats_thread()
 {
+    while (true)
+    {
+        std::this_thread::sleep_for(std::chrono::seconds(10));
+
+        std::vector<double> gate_ms = gate_latency.take();
+        std::vector<double> detect_ms = detect_latency.take();
+        std::vector<double> prep_ms = prep_latency.take();
+        std::vector<double> ocr_ms = ocr_latency.take();
+        std::cout << "[STATS] stage latency (last 10 s)" << std::endl;
+        print_latency("gate  ", summarize_latency(gate_ms));
+        print_latency("detect", summarize_latency(detect_ms));
+        print_latency("prep  ", summarize_latency(prep_ms));
+        print_latency("ocr   ", summarize_latency(ocr_ms));
+        print_queue_stats("detected_queue", detected_queue.stats());
+        print_queue_stats("prepared_queue", prepared_queue.stats());
+
+        MotionGateStats gate = motion_gate.stats();
+        std::cout << "[STATS] motion_gate frames " << gate.frames
+                  << " motion " << gate.motion
+                  << " refresh " << gate.refresh
+                  << " forced " << gate.forced
+                  << " skipped " << gate.skipped
+                  << " (" << (gate.frames ? 100.0 * gate.skipped / gate.frames : 0.0) << "% skipped)" << std::endl;
+    }
+}
+
+
+// --bench ocr <crop_dir> [iterations] : per-invoke OCR latency percentiles
+int bench_ocr(int argc, char* argv[])
+{
+    if (argc < 1) {
+        std::cerr << "Usage: lp_detect --bench ocr <crop_dir> [iterations]" << std::endl;
+        return 1;
+    }
+    int iterations = argc > 1 ? atoi(argv[1]) : 10;
+    std::vector<cv::Mat> crops = load_crop_images(argv[0]);
+    std::cout << "[BENCH] ocr: " << crops.size() << " crops, " << iterations << " iterations, "
+              << describe_ocr_engine_config(ocr_engine_config) << std::endl;
+
+    TFOCR ocr;
+    ocr.load_ocr("model.tflite", "labels.names", ocr_engine_config);
+    return run_ocr_latency_bench(ocr, crops, iterations);
+}
+
+int main(int argc, char* argv[])
+{
+    std::string ocr_config_path = "ocr_engine.json";
+    std::string debug_config_path = "debug_recorder.json";
+    std::string yolo_config_path = "yolo_engine.json";
+    MotionGateConfig motion_config;
+    int bench_arg = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--ocr-config") == 0 && i + 1 < argc) {
+            ocr_config_path = argv[++i];
+        } else if (strcmp(argv[i], "--debug-config") == 0 && i + 1 < argc) {
+            debug_config_path = argv[++i];
+        } else if (strcmp(argv[i], "--yolo-config") == 0 && i + 1 < argc) {
+            yolo_config_path = argv[++i];
+        } else if (strcmp(argv[i], "--motion-gate") == 0 && i + 1 < argc) {
+            motion_config.enabled = strcmp(argv[++i], "off") != 0;
+        } else if (strcmp(argv[i], "--motion-threshold") == 0 && i + 1 < argc) {
+            motion_config.block_threshold = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--motion-blocks") == 0 && i + 1 < argc) {
+            motion_config.min_blocks = std::max(1, atoi(argv[++i]));
+        } else if (strcmp(argv[i], "--motion-refresh") == 0 && i + 1 < argc) {
+            motion_config.refresh_ms = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--bench") == 0) {
+            bench_arg = i + 1;
+            break;
+        }
+    }
+    if (!load_ocr_engine_config(ocr_config_path, ocr_engine_config)) {
+        std::cout << "[OCR] " << ocr_config_path << " not loaded, using default engine settings" << std::endl;
+    }
+    if (!load_yolo_engine_config(yolo_config_path, yolo_engine_config)) {
+        std::cout << "[YOLO] " << yolo_config_path << " not loaded, using default ncnn options" << std::endl;
+    }
+
+    if (bench_arg > 0) {
+        if (bench_arg < argc && strcmp(argv[bench_arg], "ocr") == 0) {
+            return bench_ocr(argc - bench_arg - 1, argv + bench_arg + 1);
+        }
+        // --bench ctc [time] [classes] [iterations] : CTC decode microbenchmark
+        if (bench_arg < argc && strcmp(argv[bench_arg], "ctc") == 0) {
+            int n = argc - bench_arg - 1;
+            char** args = argv + bench_arg + 1;
+            return run_ctc_decode_bench(n > 0 ? atoi(args[0]) : 48, n > 1 ? atoi(args[1]) : 80,
+                                        n > 2 ? atoi(args[2]) : 1000);
+        }
+        return run_bench(argc - bench_arg, argv + bench_arg, yolo_engine_config);
+    }
+
+    // Debug images stay off unless the config enables some tags
+    DebugRecorderConfig debug_config;
+    load_debug_recorder_config(debug_config_path, debug_config);
+    std::cout << "[DEBUG] Debug recorder: " << describe_debug_recorder_config(debug_config) << std::endl;
+    debug_recorder().start(debug_config);
+
+    yolo.load("lp_detect_v5n.ncnn.param", "lp_detect_v5n.ncnn.bin", yolo_engine_config);
+    std::cout << "Model loaded successfully." << std::endl;
+    motion_gate.configure(motion_config);
+    signal(SIGUSR1, force_detection);
+    std::cout << "[MOTION] gate " << (motion_config.enabled ? "on" : "off")
+              << ", threshold " << motion_config.block_threshold << "/px over " << motion_config.min_blocks
+              << " blocks, refresh " << motion_config.refresh_ms << " ms" << std::endl;
+    detected_queue.set_notifier(&prep_wakeup);
+    prepared_queue.set_notifier(&ocr_wakeup);
+
     std::cout << "Starting YOLO License Plate Detection..." << std::endl;
     std::thread t1(reader_thread);    // 프레임 읽기 스레드 시작
-    std::thread t2(inference_thread); // 추론 스레드 시작
+    std::thread t2(detect_thread);    // 검출 단계
+    std::thread t3(prep_thread);      // 크롭/전처리 단계
+    std::thread t4(ocr_thread);       // OCR/출력 단계
+    std::thread t5(stats_thread);     // 단계별 지연/큐 통계
     t1.join();                        // 메인 스레드에서 대기
     t2.join();
+    t3.join();
+    t4.join();
+    t5.join();
     return 0;
 }
@@ -0,0 +1,156 @@
+#include "motion_gate.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <utility>
+
+#include <opencv2/imgproc.hpp>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define MOTION_NEON 1
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define MOTION_SSE2 1
+#endif
+
+namespace {
+
+inline uint32_t sad_scalar(const uint8_t* a, const uint8_t* b, int n) {
+    uint32_t sum = 0;
+    for (int i = 0; i < n; i++) {
+        sum += static_cast<uint32_t>(std::abs(a[i] - b[i]));
+    }
+    return sum;
+}
+
+// SAD of one tile row, 16 pixels per step
+inline uint32_t sad_row(const uint8_t* a, const uint8_t* b, int n) {
+    int i = 0;
+    uint32_t sum = 0;
+#if defined(MOTION_NEON)
+    uint32x4_t lanes = vdupq_n_u32(0);
+    for (; i + 16 <= n; i += 16) {
+        uint8x16_t diff = vabdq_u8(vld1q_u8(a + i), vld1q_u8(b + i));
+        lanes = vpadalq_u16(lanes, vpaddlq_u8(diff));
+    }
+    uint32_t parts[4];
+    vst1q_u32(parts, lanes);
+    sum = parts[0] + parts[1] + parts[2] + parts[3];
+#elif defined(MOTION_SSE2)
+    __m128i lanes = _mm_setzero_si128();
+    for (; i + 16 <= n; i += 16) {
+        __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+        __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+        lanes = _mm_add_epi64(lanes, _mm_sad_epu8(va, vb));
+    }
+    sum = static_cast<uint32_t>(_mm_cvtsi128_si32(lanes)) +
+          static_cast<uint32_t>(_mm_cvtsi128_si32(_mm_unpackhi_epi64(lanes, lanes)));
+#endif
+    return sum + sad_scalar(a + i, b + i, n - i);
+}
+
+template<uint32_t (*Row)(const uint8_t*, const uint8_t*, int)>
+void block_sad_impl(const uint8_t* a, const uint8_t* b, int stride, int width, int height, int block,
+                    std::vector<uint32_t>& out) {
+    const int blocks_x = (width + block - 1) / block;
+    const int blocks_y = (height + block - 1) / block;
+    out.assign(static_cast<size_t>(blocks_x) * blocks_y, 0);
+    for (int y = 0; y < height; y++) {
+        const uint8_t* row_a = a + static_cast<size_t>(y) * stride;
+        const uint8_t* row_b = b + static_cast<size_t>(y) * stride;
+        uint32_t* tiles = &out[static_cast<size_t>(y / block) * blocks_x];
+        for (int bx = 0; bx < blocks_x; bx++) {
+            int x = bx * block;
+            int n = x + block <= width ? block : width - x;
+            tiles[bx] += Row(row_a + x, row_b + x, n);
+        }
+    }
+}
+
+} // namespace
+
+void block_sad(const uint8_t* a, const uint8_t* b, int stride, int width, int height, int block,
+               std::vector<uint32_t>& out) {
+    block_sad_impl<sad_row>(a, b, stride, width, height, block, out);
+}
+
+void block_sad_scalar(const uint8_t* a, const uint8_t* b, int stride, int width, int height, int block,
+                      std::vector<uint32_t>& out) {
+    block_sad_impl<sad_scalar>(a, b, stride, width, height, block, out);
+}
+
+MotionDecision MotionGate::check(const cv::Mat& bgr, Clock::time_point now) {
+    frames_.fetch_add(1, std::memory_order_relaxed);
+    if (!config_.enabled) {
+        return MotionDecision::Off;
+    }
+
+    const int scale = config_.scale > 0 ? config_.scale : 1;
+    const int block = config_.block_size > 0 ? config_.block_size : 16;
+    cv::resize(bgr, small_, cv::Size(std::max(1, bgr.cols / scale), std::max(1, bgr.rows / scale)), 0, 0,
+               cv::INTER_AREA);
+    cv::cvtColor(small_, luma_, cv::COLOR_BGR2GRAY);
+
+    changed_blocks_ = 0;
+    if (has_reference_ && reference_.size() == luma_.size()) {
+        block_sad(luma_.data, reference_.data, static_cast<int>(luma_.step), luma_.cols, luma_.rows, block, sad_);
+        const int blocks_x = (luma_.cols + block - 1) / block;
+        for (size_t i = 0; i < sad_.size(); i++) {
+            // Edge tiles are partial, compare against their own area
+            int tile_w = std::min(block, luma_.cols - static_cast<int>(i % blocks_x) * block);
+            int tile_h = std::min(block, luma_.rows - static_cast<int>(i / blocks_x) * block);
+            if (sad_[i] > static_cast<uint32_t>(config_.block_threshold * tile_w * tile_h)) {
+                changed_blocks_++;
+            }
+        }
+    } else {
+        return pass(MotionDecision::Refresh, now);
+    }
+
+    if (force_.exchange(false, std::memory_order_relaxed) || now < hold_until_) {
+        return pass(MotionDecision::Forced, now);
+    }
+    if (changed_blocks_ >= config_.min_blocks) {
+        return pass(MotionDecision::Motion, now);
+    }
+    if (now - last_detect_ >= std::chrono::milliseconds(config_.refresh_ms)) {
+        return pass(MotionDecision::Refresh, now);
+    }
+    skipped_.fetch_add(1, std::memory_order_relaxed);
+    return MotionDecision::Skip;
+}
+
+MotionDecision MotionGate::pass(MotionDecision decision, Clock::time_point now) {
+    std::swap(luma_, reference_);   // keeps both buffers allocated
+    has_reference_ = true;
+    last_detect_ = now;
+    switch (decision) {
+    case MotionDecision::Motion:
+        motion_.fetch_add(1, std::memory_order_relaxed);
+        break;
+    case MotionDecision::Refresh:
+        refresh_.fetch_add(1, std::memory_order_relaxed);
+        break;
+    default:
+        forced_.fetch_add(1, std::memory_order_relaxed);
+        break;
+    }
+    return decision;
+}
+
+void MotionGate::report(size_t objects, Clock::time_point now) {
+    if (objects > 0) {
+        hold_until_ = now + std::chrono::milliseconds(config_.hold_ms);
+    }
+}
+
+MotionGateStats MotionGate::stats() const {
+    MotionGateStats stats;
+    stats.frames = frames_.load(std::memory_order_relaxed);
+    stats.skipped = skipped_.load(std::memory_order_relaxed);
+    stats.motion = motion_.load(std::memory_order_relaxed);
+    stats.refresh = refresh_.load(std::memory_order_relaxed);
+    stats.forced = forced_.load(std::memory_order_relaxed);
+    return stats;
+}
@@ -0,0 +1,99 @@
+#ifndef MOTION_GATE_HPP
+#define MOTION_GATE_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+#include <opencv2/core.hpp>
+
+// Sum of absolute differences of every block x block tile of two 8-bit
+// planes, row-major into `out` (ceil(width / block) * ceil(height / block)
+// entries; edge tiles are partial). Uses NEON or SSE2 when the build
+// targets them; the result is identical to the scalar version.
+void block_sad(const uint8_t* a, const uint8_t* b, int stride, int width, int height, int block,
+               std::vector<uint32_t>& out);
+void block_sad_scalar(const uint8_t* a, const uint8_t* b, int stride, int width, int height, int block,
+                      std::vector<uint32_t>& out);
+
+struct MotionGateConfig {
+    bool enabled = true;
+    int scale = 4;                  // 1280x720 -> 320x180 luma
+    int block_size = 16;            // tile side on the downscaled plane
+    int block_threshold = 12;       // mean |luma diff| per pixel of a changed tile
+    int min_blocks = 2;             // changed tiles that count as motion
+    int refresh_ms = 2000;          // detect at least this often
+    int hold_ms = 1000;             // keep detecting this long after plates were seen
+};
+
+// Why check() let a frame through, or Skip
+enum class MotionDecision {
+    Skip,
+    Motion,         // enough tiles changed since the last detected frame
+    Refresh,        // refresh_ms since the last detection (or first frame)
+    Forced,         // force_next(), or plates were in view within hold_ms
+    Off             // gate disabled
+};
+
+struct MotionGateStats {
+    uint64_t frames;
+    uint64_t skipped;
+    uint64_t motion;
+    uint64_t refresh;
+    uint64_t forced;
+};
+
+// --- Motion gate in front of the detector ---
+// Each frame is reduced to a small luma plane (INTER_AREA resize, then
+// gray) and compared tile by tile with the plane of the last frame that
+// went through detection. Comparing against that reference instead of the
+// previous frame means slow changes add up until they count as motion.
+// Static scenes skip YOLO entirely; refresh_ms and the hold after plates
+// were seen bound how stale the published result can get.
+//
+// check() and report() belong to one thread (the detect stage);
+// force_next() and stats() may be called from anywhere, force_next() also
+// from a signal handler.
+class MotionGate {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    void configure(const MotionGateConfig& config) { config_ = config; }
+    const MotionGateConfig& config() const { return config_; }
+
+    // Decide whether `bgr` needs a full detection. A frame that is let
+    // through becomes the new reference.
+    MotionDecision check(const cv::Mat& bgr, Clock::time_point now);
+    // Outcome of the detection check() asked for
+    void report(size_t objects, Clock::time_point now);
+    // Let the next frame through regardless of motion
+    void force_next() { force_.store(true, std::memory_order_relaxed); }
+
+    // Tiles that changed in the last check()
+    int changedBlocks() const { return changed_blocks_; }
+    MotionGateStats stats() const;
+
+private:
+    MotionDecision pass(MotionDecision decision, Clock::time_point now);
+
+    MotionGateConfig config_;
+    std::atomic<bool> force_{false};
+
+    cv::Mat small_;                 // downscaled BGR, reused
+    cv::Mat luma_;                  // current plane
+    cv::Mat reference_;             // plane of the last detected frame
+    std::vector<uint32_t> sad_;
+    int changed_blocks_ = 0;
+    bool has_reference_ = false;
+    Clock::time_point last_detect_;
+    Clock::time_point hold_until_;
+
+    std::atomic<uint64_t> frames_{0};
+    std::atomic<uint64_t> skipped_{0};
+    std::atomic<uint64_t> motion_{0};
+    std::atomic<uint64_t> refresh_{0};
+    std::atomic<uint64_t> forced_{0};
+};
+
+#endif // MOTION_GATE_HPP
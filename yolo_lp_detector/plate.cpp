@@ -1,14 +1,14 @@
 #include "plate.hpp"
 #include <iostream>
-#include <sys/stat.h>
 
-PlatePrep::PlatePrep(const std::string& preprocess_dir) : preprocess_dir(preprocess_dir) {
-    mkdir(this->preprocess_dir.c_str(), 0777);
+PlatePrep::PlatePrep() : debug_tag(debug_recorder().tag("plate_prep")) {
 }
 
+// Stage images go to the debug recorder, and only for sampled crops
 void PlatePrep::save(const cv::Mat& img, const std::string& filename) {
-    std::string full_path = preprocess_dir + "/" + filename;
-    cv::imwrite(full_path, img);
+    if (debug) {
+        debug_recorder().record(debug_tag, img, filename);
+    }
 }
 
 std::vector<cv::Point2f> PlatePrep::order_points(const std::vector<cv::Point>& pts) {
@@ -69,6 +69,8 @@ cv::Mat PlatePrep::preprocess(const cv::Mat& input, float resize_factor) {
 // }
 
 bool PlatePrep::extract_plate_region(const cv::Mat& input, cv::Mat& output_plate, const std::string& prefix) {
+    debug = debug_recorder().sample(debug_tag);
+
     cv::Mat hsv;
     cv::cvtColor(input, hsv, cv::COLOR_BGR2HSV);
     save(hsv, prefix + "01_hsv.png");
@@ -109,10 +111,12 @@ bool PlatePrep::extract_plate_region(const cv::Mat& input, cv::Mat& output_plate
 
     std::vector<cv::Point2f> corners = order_points(candidate);
 
-    cv::Mat temp = input.clone();
-    for (const auto& pt : corners)
-        cv::circle(temp, pt, 5, cv::Scalar(0, 255, 0), -1);
-    save(temp, prefix + "05_detected_corners.png");
+    if (debug) {
+        cv::Mat temp = input.clone();
+        for (const auto& pt : corners)
+            cv::circle(temp, pt, 5, cv::Scalar(0, 255, 0), -1);
+        save(temp, prefix + "05_detected_corners.png");
+    }
 
     cv::Point2f tl = corners[0], tr = corners[1], br = corners[2], bl = corners[3];
     int width = static_cast<int>(std::max(cv::norm(br - bl), cv::norm(tr - tl)));
@@ -5,6 +5,8 @@
 #include <string>
 #include <vector>
 
+#include "debug_recorder.hpp"
+
 struct OcrResult {
     int number;
     int reliability;    // 0: 하단만 정확, 1: 상+하단 정확, -1: 실패
@@ -14,11 +16,12 @@ struct OcrResult {
 
 class PlatePrep {
 public:
-    PlatePrep(const std::string& preprocess_dir = "preprocess");
+    PlatePrep();
     cv::Mat preprocess_plate(const cv::Mat& input_img, int index);
 
 private:
-    std::string preprocess_dir;
+    DebugTag debug_tag;     // "plate_prep" stage images
+    bool debug = false;     // current crop was sampled for the debug recorder
 
     void save(const cv::Mat& img, const std::string& filename);
     std::vector<cv::Point2f> order_points(const std::vector<cv::Point>& pts);
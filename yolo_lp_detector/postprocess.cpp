@@ -0,0 +1,299 @@
+#include "postprocess.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+namespace {
+
+// Grid cell of coordinate `v`, clamped to [0, count)
+inline int cell_of(float v, float origin, float inv_cell, int count)
+{
+    float f = (v - origin) * inv_cell;
+    if (!(f > 0.f))
+        return 0;
+    if (f >= count)
+        return count - 1;
+    return static_cast<int>(f);
+}
+
+// Same arithmetic as (a.rect & b.rect).area() on cv::Rect_<float>
+inline float intersection_area(const Proposals& p, int a, int b)
+{
+    float x0 = std::max(p.x[a], p.x[b]);
+    float y0 = std::max(p.y[a], p.y[b]);
+    float w = std::min(p.x[a] + p.width[a], p.x[b] + p.width[b]) - x0;
+    float h = std::min(p.y[a] + p.height[a], p.y[b] + p.height[b]) - y0;
+    if (w <= 0.f || h <= 0.f)
+        return 0.f;
+    return w * h;
+}
+
+// Letterboxed box -> clipped box in input image coordinates
+inline void to_image_coords(const YoloOutput& output, Object& obj)
+{
+    const int img_w = output.img_w;
+    const int img_h = output.img_h;
+    const float scale = output.scale;
+    const int wpad = output.wpad;
+    const int hpad = output.hpad;
+
+    // adjust offset to original unpadded
+    float x0 = (obj.rect.x - (wpad / 2)) / scale;
+    float y0 = (obj.rect.y - (hpad / 2)) / scale;
+    float x1 = (obj.rect.x + obj.rect.width - (wpad / 2)) / scale;
+    float y1 = (obj.rect.y + obj.rect.height - (hpad / 2)) / scale;
+
+    // clip
+    x0 = std::max(std::min(x0, (float)(img_w - 1)), 0.f);
+    y0 = std::max(std::min(y0, (float)(img_h - 1)), 0.f);
+    x1 = std::max(std::min(x1, (float)(img_w - 1)), 0.f);
+    y1 = std::max(std::min(y1, (float)(img_h - 1)), 0.f);
+
+    obj.rect.x = x0;
+    obj.rect.y = y0;
+    obj.rect.width = x1 - x0;
+    obj.rect.height = y1 - y0;
+}
+
+} // namespace
+
+ProposalNms::ProposalNms(size_t max_candidates, float cell_size)
+    : max_candidates_(max_candidates), cell_size_(cell_size)
+{
+}
+
+const std::vector<int>& ProposalNms::run(const Proposals& proposals, float nms_threshold, bool agnostic)
+{
+    picked_.clear();
+    const int n = static_cast<int>(proposals.size());
+
+    // Best max_candidates by score; equal scores keep decoding order
+    const std::vector<float>& prob = proposals.prob;
+    auto higher = [&prob](int a, int b) { return prob[a] > prob[b] || (prob[a] == prob[b] && a < b); };
+    order_.resize(n);
+    std::iota(order_.begin(), order_.end(), 0);
+    size_t count = std::min<size_t>(n, max_candidates_);
+    truncated_ = n - count;
+    if (count < order_.size())
+    {
+        std::nth_element(order_.begin(), order_.begin() + count, order_.end(), higher);
+        order_.resize(count);
+    }
+    std::sort(order_.begin(), order_.end(), higher);
+    if (order_.empty())
+        return picked_;
+
+    // Grid over the candidates' extent, at most 32 x 32 cells
+    float min_x = proposals.x[order_[0]], min_y = proposals.y[order_[0]];
+    float max_x = min_x, max_y = min_y;
+    areas_.resize(n);
+    for (int i : order_)
+    {
+        min_x = std::min(min_x, proposals.x[i]);
+        min_y = std::min(min_y, proposals.y[i]);
+        max_x = std::max(max_x, proposals.x[i] + proposals.width[i]);
+        max_y = std::max(max_y, proposals.y[i] + proposals.height[i]);
+        areas_[i] = proposals.width[i] * proposals.height[i];
+    }
+    const int grid_w = std::max(1, std::min(32, static_cast<int>(std::ceil((max_x - min_x) / cell_size_))));
+    const int grid_h = std::max(1, std::min(32, static_cast<int>(std::ceil((max_y - min_y) / cell_size_))));
+    const float inv_cell_w = grid_w / std::max(max_x - min_x, 1e-6f);
+    const float inv_cell_h = grid_h / std::max(max_y - min_y, 1e-6f);
+    if (cells_.size() < static_cast<size_t>(grid_w * grid_h))
+        cells_.resize(grid_w * grid_h);
+    for (int c = 0; c < grid_w * grid_h; c++)
+        cells_[c].clear();
+    checked_.clear();
+
+    // A negative threshold suppresses disjoint boxes too; the grid cannot help
+    const bool all_pairs = !(nms_threshold >= 0.f);
+
+    for (size_t rank = 0; rank < order_.size(); rank++)
+    {
+        const int i = order_[rank];
+        const int cx0 = cell_of(proposals.x[i], min_x, inv_cell_w, grid_w);
+        const int cx1 = cell_of(proposals.x[i] + proposals.width[i], min_x, inv_cell_w, grid_w);
+        const int cy0 = cell_of(proposals.y[i], min_y, inv_cell_h, grid_h);
+        const int cy1 = cell_of(proposals.y[i] + proposals.height[i], min_y, inv_cell_h, grid_h);
+
+        auto suppresses = [&](int kept) {
+            const int j = picked_[kept];
+            if (!agnostic && proposals.label[i] != proposals.label[j])
+                return false;
+            // intersection over union
+            float inter_area = intersection_area(proposals, i, j);
+            float union_area = areas_[i] + areas_[j] - inter_area;
+            return inter_area / union_area > nms_threshold;
+        };
+
+        bool keep = true;
+        if (all_pairs)
+        {
+            for (size_t kept = 0; kept < picked_.size() && keep; kept++)
+                keep = !suppresses(static_cast<int>(kept));
+        }
+        else
+        {
+            for (int cy = cy0; cy <= cy1 && keep; cy++)
+            {
+                for (int cx = cx0; cx <= cx1 && keep; cx++)
+                {
+                    for (int kept : cells_[cy * grid_w + cx])
+                    {
+                        // A kept box spanning several cells is tested once
+                        if (checked_[kept] == static_cast<int>(rank))
+                            continue;
+                        checked_[kept] = static_cast<int>(rank);
+                        if (suppresses(kept))
+                        {
+                            keep = false;
+                            break;
+                        }
+                    }
+                }
+            }
+        }
+
+        if (keep)
+        {
+            const int kept = static_cast<int>(picked_.size());
+            picked_.push_back(i);
+            checked_.push_back(-1);
+            for (int cy = cy0; cy <= cy1; cy++)
+                for (int cx = cx0; cx <= cx1; cx++)
+                    cells_[cy * grid_w + cx].push_back(kept);
+        }
+    }
+    return picked_;
+}
+
+static inline float intersection_area(const Object& a, const Object& b)
+{
+    cv::Rect_<float> inter = a.rect & b.rect;
+    return inter.area();
+}
+
+static void qsort_descent_inplace(std::vector<Object>& faceobjects, int left, int right)
+{
+    int i = left;
+    int j = right;
+    float p = faceobjects[(left + right) / 2].prob;
+
+    while (i <= j)
+    {
+        while (faceobjects[i].prob > p)
+            i++;
+
+        while (faceobjects[j].prob < p)
+            j--;
+
+        if (i <= j)
+        {
+            // swap
+            std::swap(faceobjects[i], faceobjects[j]);
+
+            i++;
+            j--;
+        }
+    }
+
+    #pragma omp parallel sections
+    {
+        #pragma omp section
+        {
+            if (left < j) qsort_descent_inplace(faceobjects, left, j);
+        }
+        #pragma omp section
+        {
+            if (i < right) qsort_descent_inplace(faceobjects, i, right);
+        }
+    }
+}
+
+static void qsort_descent_inplace(std::vector<Object>& faceobjects)
+{
+    if (faceobjects.empty())
+        return;
+
+    qsort_descent_inplace(faceobjects, 0, faceobjects.size() - 1);
+}
+
+static void nms_sorted_bboxes(const std::vector<Object>& faceobjects, std::vector<int>& picked, float nms_threshold, bool agnostic)
+{
+    picked.clear();
+
+    const int n = faceobjects.size();
+
+    std::vector<float> areas(n);
+    for (int i = 0; i < n; i++)
+    {
+        areas[i] = faceobjects[i].rect.area();
+    }
+
+    for (int i = 0; i < n; i++)
+    {
+        const Object& a = faceobjects[i];
+
+        int keep = 1;
+        for (int j = 0; j < (int)picked.size(); j++)
+        {
+            const Object& b = faceobjects[picked[j]];
+
+            if (!agnostic && a.label != b.label)
+                continue;
+
+            // intersection over union
+            float inter_area = intersection_area(a, b);
+            float union_area = areas[i] + areas[picked[j]] - inter_area;
+            // float IoU = inter_area / union_area
+            if (inter_area / union_area > nms_threshold)
+                keep = 0;
+        }
+
+        if (keep)
+            picked.push_back(i);
+    }
+}
+
+void nms_reference(std::vector<Object>& objects, std::vector<int>& picked, float nms_threshold, bool agnostic)
+{
+    qsort_descent_inplace(objects);
+    nms_sorted_bboxes(objects, picked, nms_threshold, agnostic);
+}
+
+void YoloPostprocess::run(const YoloOutput& output, float prob_threshold, float nms_threshold, std::vector<Object>& objects)
+{
+    proposals_.clear();
+    for (int s = 0; s < 3; s++)
+        generate_proposals(YOLO_ANCHORS[s], 3, YOLO_STRIDES[s], output.out[s], prob_threshold, proposals_);
+
+    const std::vector<int>& picked = nms_.run(proposals_, nms_threshold);
+
+    // collect final result after nms
+    objects.resize(picked.size());
+    for (size_t i = 0; i < picked.size(); i++)
+    {
+        objects[i] = proposals_.object(picked[i]);
+        to_image_coords(output, objects[i]);
+    }
+}
+
+void yolo_postprocess_reference(const YoloOutput& output, float prob_threshold, float nms_threshold,
+                                std::vector<Object>& objects)
+{
+    std::vector<Object> proposals;
+    for (int s = 0; s < 3; s++)
+        generate_proposals_reference(YOLO_ANCHORS[s], 3, YOLO_STRIDES[s], output.out[s], prob_threshold, proposals);
+
+    std::vector<int> picked;
+    nms_reference(proposals, picked, nms_threshold);
+
+    const int count = picked.size();
+    objects.resize(count);
+    for (int i = 0; i < count; i++)
+    {
+        objects[i] = proposals[picked[i]];
+        to_image_coords(output, objects[i]);
+    }
+}
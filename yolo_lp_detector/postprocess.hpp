@@ -0,0 +1,69 @@
+#ifndef POSTPROCESS_HPP
+#define POSTPROCESS_HPP
+
+#include <cstddef>
+#include <vector>
+
+#include "proposals.hpp"
+
+// --- Score-ordered non-maximum suppression on SoA proposals ---
+// Candidates are ranked by score (ties by position) with nth_element down
+// to the best `max_candidates`, and only those are sorted. Kept boxes are
+// registered in a uniform grid over the letterboxed input; a candidate is
+// tested only against kept boxes sharing a grid cell with it, since boxes
+// that do not overlap have IoU 0 and can never suppress each other.
+//
+// With no more than `max_candidates` proposals (and no exact score ties
+// between overlapping boxes) the picks equal those of the former quicksort
+// + all-pairs NMS (nms_reference()).
+class ProposalNms
+{
+public:
+    ProposalNms(size_t max_candidates = 1024, float cell_size = 64.f);
+
+    void setMaxCandidates(size_t max_candidates) { max_candidates_ = max_candidates; }
+
+    // Indices into `proposals` of the kept boxes, highest score first.
+    // Boxes of different labels do not suppress each other unless `agnostic`.
+    const std::vector<int>& run(const Proposals& proposals, float nms_threshold, bool agnostic = false);
+
+    // Proposals beyond max_candidates in the last run()
+    size_t truncated() const { return truncated_; }
+
+private:
+    size_t max_candidates_;
+    float cell_size_;
+    size_t truncated_ = 0;
+
+    // Reused across frames
+    std::vector<int> order_;
+    std::vector<int> picked_;
+    std::vector<float> areas_;
+    std::vector<std::vector<int>> cells_;  // kept boxes (positions in picked_) per grid cell
+    std::vector<int> checked_;             // last candidate each kept box was tested against
+};
+
+// --- Detector post-processing ---
+// Head outputs -> SoA proposals -> top-k + grid NMS -> Objects in input
+// image coordinates. Keeps its buffers between frames; one per thread.
+class YoloPostprocess
+{
+public:
+    void run(const YoloOutput& output, float prob_threshold, float nms_threshold, std::vector<Object>& objects);
+    ProposalNms& nms() { return nms_; }
+
+private:
+    Proposals proposals_;
+    ProposalNms nms_;
+};
+
+// The former quicksort (by score, descending) and all-pairs NMS; sorts
+// `objects` in place. Kept as the regression reference.
+void nms_reference(std::vector<Object>& objects, std::vector<int>& picked, float nms_threshold, bool agnostic = false);
+
+// The whole former post-processing path (per-cell decoder, AoS objects,
+// quicksort, all-pairs NMS)
+void yolo_postprocess_reference(const YoloOutput& output, float prob_threshold, float nms_threshold,
+                                std::vector<Object>& objects);
+
+#endif // POSTPROCESS_HPP
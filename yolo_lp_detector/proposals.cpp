@@ -0,0 +1,280 @@
+#include "proposals.hpp"
+
+#include <cfloat>
+#include <cmath>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+inline float sigmoid(float x)
+{
+    return static_cast<float>(1.f / (1.f + exp(-x)));
+}
+
+// Lowest box logit that can still reach prob_threshold. The margin keeps
+// float rounding in sigmoid() from rejecting a cell the reference keeps.
+float box_logit_threshold(float prob_threshold)
+{
+    if (!(prob_threshold > 0.f) || !(prob_threshold < 1.f))
+        return -FLT_MAX;
+    return std::log(prob_threshold / (1.f - prob_threshold)) - 1e-3f;
+}
+
+// First index in [begin, count) whose logit is >= threshold, count if none
+inline int next_candidate(const float* logits, int begin, int count, float threshold)
+{
+    int k = begin;
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+    const float32x4_t t = vdupq_n_f32(threshold);
+    for (; k + 4 <= count; k += 4)
+    {
+        uint32x4_t ge = vcgeq_f32(vld1q_f32(logits + k), t);
+        uint32x2_t any = vorr_u32(vget_low_u32(ge), vget_high_u32(ge));
+        if (vget_lane_u32(vpmax_u32(any, any), 0))
+            break;
+    }
+#elif defined(__SSE2__)
+    const __m128 t = _mm_set1_ps(threshold);
+    for (; k + 4 <= count; k += 4)
+    {
+        if (_mm_movemask_ps(_mm_cmpge_ps(_mm_loadu_ps(logits + k), t)))
+            break;
+    }
+#endif
+    for (; k < count; k++)
+    {
+        if (logits[k] >= threshold)
+            return k;
+    }
+    return count;
+}
+
+} // namespace
+
+void Proposals::clear()
+{
+    x.clear();
+    y.clear();
+    width.clear();
+    height.clear();
+    prob.clear();
+    label.clear();
+}
+
+void Proposals::push(float x0, float y0, float w, float h, float score, int class_index)
+{
+    x.push_back(x0);
+    y.push_back(y0);
+    width.push_back(w);
+    height.push_back(h);
+    prob.push_back(score);
+    label.push_back(class_index);
+}
+
+Object Proposals::object(size_t i) const
+{
+    Object obj;
+    obj.rect.x = x[i];
+    obj.rect.y = y[i];
+    obj.rect.width = width[i];
+    obj.rect.height = height[i];
+    obj.label = label[i];
+    obj.prob = prob[i];
+    return obj;
+}
+
+void generate_proposals(const float* anchors, int num_anchors, int stride, const ncnn::Mat& feat_blob,
+                        float prob_threshold, Proposals& proposals)
+{
+    const int num_grid_x = feat_blob.w;
+    const int num_grid_y = feat_blob.h;
+    const int num_cells = num_grid_x * num_grid_y;
+
+    const int num_class = feat_blob.c / num_anchors - 5;
+
+    const int feat_offset = num_class + 5;
+
+    const float logit_threshold = box_logit_threshold(prob_threshold);
+
+    // Each channel is one dense grid_w * grid_h plane
+    std::vector<const float*> rows(feat_offset);
+
+    for (int q = 0; q < num_anchors; q++)
+    {
+        const float anchor_w = anchors[q * 2];
+        const float anchor_h = anchors[q * 2 + 1];
+
+        for (int c = 0; c < feat_offset; c++)
+            rows[c] = feat_blob.channel(q * feat_offset + c);
+        const float* box_logits = rows[4];
+
+        for (int k = next_candidate(box_logits, 0, num_cells, logit_threshold); k < num_cells;
+             k = next_candidate(box_logits, k + 1, num_cells, logit_threshold))
+        {
+            // find class index with max class score
+            int class_index = 0;
+            float class_score = -FLT_MAX;
+            for (int c = 0; c < num_class; c++)
+            {
+                float score = rows[5 + c][k];
+                if (score > class_score)
+                {
+                    class_index = c;
+                    class_score = score;
+                }
+            }
+
+            float confidence = sigmoid(box_logits[k]) * sigmoid(class_score);
+            if (confidence < prob_threshold)
+                continue;
+
+            const int i = k / num_grid_x;
+            const int j = k - i * num_grid_x;
+
+            float dx = sigmoid(rows[0][k]);
+            float dy = sigmoid(rows[1][k]);
+            float dw = sigmoid(rows[2][k]);
+            float dh = sigmoid(rows[3][k]);
+
+            float cx = (dx * 2.f - 0.5f + j) * stride;
+            float cy = (dy * 2.f - 0.5f + i) * stride;
+
+            float bw = pow(dw * 2.f, 2) * anchor_w;
+            float bh = pow(dh * 2.f, 2) * anchor_h;
+
+            float x0 = cx - bw * 0.5f;
+            float y0 = cy - bh * 0.5f;
+            float x1 = cx + bw * 0.5f;
+            float y1 = cy + bh * 0.5f;
+
+            proposals.push(x0, y0, x1 - x0, y1 - y0, confidence, class_index);
+        }
+    }
+}
+
+void generate_proposals_reference(const float* anchors, int num_anchors, int stride, const ncnn::Mat& feat_blob,
+                                  float prob_threshold, std::vector<Object>& objects)
+{
+    // the out blob would be a 3-dim tensor with w=dynamic h=dynamic c=255=85*3
+    // we view it as [grid_w,grid_h,85,3] for 3 anchor ratio types
+
+    //
+    //            |<--   dynamic anchor grids     -->|
+    //            |   larger image yields more grids |
+    //            +-------------------------- // ----+
+    //           /| center-x                         |
+    //          / | center-y                         |
+    //         /  | box-w                            |
+    // anchor-0   | box-h                            |
+    //  +-----+   | box score(1)                     |
+    //  |     |   +----------------                  |
+    //  |     |   | per-class scores(80)             |
+    //  +-----+\  |   .                              |
+    //          \ |   .                              |
+    //           \|   .                              |
+    //            +-------------------------- // ----+
+    //           /| center-x                         |
+    //          / | center-y                         |
+    //         /  | box-w                            |
+    // anchor-1   | box-h                            |
+    //  +-----+   | box score(1)                     |
+    //  |     |   +----------------                  |
+    //  +-----+   | per-class scores(80)             |
+    //         \  |   .                              |
+    //          \ |   .                              |
+    //           \|   .                              |
+    //            +-------------------------- // ----+
+    //           /| center-x                         |
+    //          / | center-y                         |
+    //         /  | box-w                            |
+    // anchor-2   | box-h                            |
+    //  +--+      | box score(1)                     |
+    //  |  |      +----------------                  |
+    //  |  |      | per-class scores(80)             |
+    //  +--+   \  |   .                              |
+    //          \ |   .                              |
+    //           \|   .                              |
+    //            +-------------------------- // ----+
+    //
+
+    const int num_grid_x = feat_blob.w;
+    const int num_grid_y = feat_blob.h;
+
+    const int num_class = feat_blob.c / num_anchors - 5;
+
+    const int feat_offset = num_class + 5;
+
+    // enumerate all anchor types
+    for (int q = 0; q < num_anchors; q++)
+    {
+        const float anchor_w = anchors[q * 2];
+        const float anchor_h = anchors[q * 2 + 1];
+
+        for (int i = 0; i < num_grid_y; i++)
+        {
+            for (int j = 0; j < num_grid_x; j++)
+            {
+                // find class index with max class score
+                int class_index = 0;
+                float class_score = -FLT_MAX;
+                for (int k = 0; k < num_class; k++)
+                {
+                    float score = feat_blob.channel(q * feat_offset + 5 + k).row(i)[j];
+                    if (score > class_score)
+                    {
+                        class_index = k;
+                        class_score = score;
+                    }
+                }
+
+                float box_score = feat_blob.channel(q * feat_offset + 4).row(i)[j];
+
+                // combined score = box score * class score
+                // apply sigmoid first to get normed 0~1 value
+                float confidence = sigmoid(box_score) * sigmoid(class_score);
+
+                // filter candidate boxes with combined score >= prob_threshold
+                if (confidence < prob_threshold)
+                    continue;
+
+                // yolov5/models/yolo.py Detect forward
+                // y = x[i].sigmoid()
+                // y[..., 0:2] = (y[..., 0:2] * 2. - 0.5 + self.grid[i].to(x[i].device)) * self.stride[i]  # xy
+                // y[..., 2:4] = (y[..., 2:4] * 2) ** 2 * self.anchor_grid[i]  # wh
+
+                float dx = sigmoid(feat_blob.channel(q * feat_offset + 0).row(i)[j]);
+                float dy = sigmoid(feat_blob.channel(q * feat_offset + 1).row(i)[j]);
+                float dw = sigmoid(feat_blob.channel(q * feat_offset + 2).row(i)[j]);
+                float dh = sigmoid(feat_blob.channel(q * feat_offset + 3).row(i)[j]);
+
+                float cx = (dx * 2.f - 0.5f + j) * stride;
+                float cy = (dy * 2.f - 0.5f + i) * stride;
+
+                float bw = pow(dw * 2.f, 2) * anchor_w;
+                float bh = pow(dh * 2.f, 2) * anchor_h;
+
+                // transform candidate box (center-x,center-y,w,h) to (x0,y0,x1,y1)
+                float x0 = cx - bw * 0.5f;
+                float y0 = cy - bh * 0.5f;
+                float x1 = cx + bw * 0.5f;
+                float y1 = cy + bh * 0.5f;
+
+                // collect candidates
+                Object obj;
+                obj.rect.x = x0;
+                obj.rect.y = y0;
+                obj.rect.width = x1 - x0;
+                obj.rect.height = y1 - y0;
+                obj.label = class_index;
+                obj.prob = confidence;
+
+                objects.push_back(obj);
+            }
+        }
+    }
+}
@@ -0,0 +1,46 @@
+#ifndef PROPOSALS_HPP
+#define PROPOSALS_HPP
+
+#include <vector>
+
+#include <ncnn/net.h>
+
+#include "yolo.hpp"
+
+// Candidate boxes in letterboxed input coordinates, one array per field.
+// Boxes are kept as (x, y, width, height) exactly like Object::rect so
+// everything computed from them matches the Object path bit for bit.
+struct Proposals
+{
+    std::vector<float> x;
+    std::vector<float> y;
+    std::vector<float> width;
+    std::vector<float> height;
+    std::vector<float> prob;
+    std::vector<int> label;
+
+    size_t size() const { return prob.size(); }
+    void clear();
+    void push(float x0, float y0, float w, float h, float score, int class_index);
+    Object object(size_t i) const;
+};
+
+// YOLOv5 head decoding of one output blob, [grid_w, grid_h, (5 + classes) * anchors],
+// into candidate boxes in letterboxed input coordinates. `anchors` holds
+// num_anchors (w, h) pairs.
+//
+// Cells are rejected on the raw box logit first: box and class scores are
+// both sigmoids, so confidence <= sigmoid(box) and any cell whose box logit
+// is below logit(prob_threshold) cannot pass. The logits of each anchor are
+// scanned four at a time (NEON/SSE) straight from the channel rows; only the
+// few surviving cells get the class argmax, sigmoids and box decode. Output
+// (values and order) matches generate_proposals_reference(). Appends to
+// `proposals`.
+void generate_proposals(const float* anchors, int num_anchors, int stride, const ncnn::Mat& feat_blob,
+                        float prob_threshold, Proposals& proposals);
+
+// The former per-cell decoder, kept as the benchmark reference
+void generate_proposals_reference(const float* anchors, int num_anchors, int stride, const ncnn::Mat& feat_blob,
+                                  float prob_threshold, std::vector<Object>& objects);
+
+#endif // PROPOSALS_HPP
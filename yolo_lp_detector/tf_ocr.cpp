@@ -1,5 +1,6 @@
 // main.cpp
 #include "tf_ocr.hpp"
+#include <chrono>
 
 std::map<int, std::string> TFOCR::loadLabelMap(const std::string& path) {
     std::map<int, std::string> label_map;
@@ -12,37 +13,34 @@ std::map<int, std::string> TFOCR::loadLabelMap(const std::string& path) {
     return label_map;
 }
 
-std::vector<int> TFOCR::ctcGreedyDecoder(const float* logits, int time, int classes) {
-    std::vector<int> result;
-    int prev = -1;
-    for (int t = 0; t < time; ++t) {
-        int max_index = 0;
-        float max_val = logits[t * classes];
-        for (int c = 1; c < classes; ++c) {
-            float val = logits[t * classes + c];
-            if (val > max_val) {
-                max_val = val;
-                max_index = c;
-            }
-        }
-        if (max_index != prev && max_index != 0) {
-            result.push_back(max_index);
-        }
-        prev = max_index;
-    }
-    return result;
-}
-
-void TFOCR::load_ocr(const std::string& model_path, const std::string& labels_path) {
+void TFOCR::load_ocr(const std::string& model_path, const std::string& labels_path,
+                     const OcrEngineConfig& engine_config) {
     // Load label map
     label_map = loadLabelMap(labels_path);
 
-    // Load TFLite model
+    // Load TFLite model (mmap'd) and build the interpreter with the engine settings
     model = tflite::FlatBufferModel::BuildFromFile(model_path.c_str());
-    tflite::ops::builtin::BuiltinOpResolver resolver;
-    // Removed local interpreter declaration, now using member variable
-    tflite::InterpreterBuilder(*model, resolver)(&interpreter);
-    interpreter->AllocateTensors();
+    if (!model) {
+        std::cerr << "[OCR] Failed to load model " << model_path << std::endl;
+        return;
+    }
+    interpreter = build_ocr_interpreter(*model, engine_config);
+    if (!interpreter) {
+        return;
+    }
+    std::cout << "[OCR] Engine: " << describe_ocr_engine_config(engine_config) << std::endl;
+
+    // float32 or fully integer (int8/uint8) quantized models
+    const TfLiteTensor* input_tensor = interpreter->tensor(interpreter->inputs()[0]);
+    const TfLiteTensor* output_tensor = interpreter->tensor(interpreter->outputs()[0]);
+    if (!ocr_tensor_type_supported(input_tensor) || !ocr_tensor_type_supported(output_tensor)) {
+        std::cerr << "[OCR] Unsupported model tensors: input " << ocr_tensor_type_name(input_tensor)
+                  << ", output " << ocr_tensor_type_name(output_tensor) << std::endl;
+        interpreter.reset();
+        return;
+    }
+    std::cout << "[OCR] Model input " << ocr_tensor_type_name(input_tensor)
+              << ", output " << ocr_tensor_type_name(output_tensor) << std::endl;
 
     // Set input and output details
     // auto input_details = interpreter->inputs();
@@ -52,33 +50,37 @@ void TFOCR::load_ocr(const std::string& model_path, const std::string& labels_pa
 }
 
 std::string TFOCR::run_ocr(const cv::Mat& input_img) {
+    if (!interpreter) {
+        return "";
+    }
 
     cv::Mat gray;
     cv::cvtColor(input_img, gray, cv::COLOR_BGR2GRAY);
-    cv::resize(gray, gray, cv::Size(192, 96));
-    gray.convertTo(gray, CV_32FC1, 1.0 / 255.0);
+    cv::resize(gray, resized_input, cv::Size(192, 96));
 
-    // Set input
-    float* input = interpreter->typed_input_tensor<float>(0);
-    memcpy(input, gray.data, 96 * 192 * sizeof(float));
+    // Set input: normalized to 0..1, quantized for integer models
+    write_ocr_input(resized_input, 1.0 / 255.0, 0.0, false, interpreter->tensor(interpreter->inputs()[0]), 0);
 
     // Run inference
-    if (interpreter->Invoke() != kTfLiteOk) {
+    auto start = std::chrono::steady_clock::now();
+    TfLiteStatus status = interpreter->Invoke();
+    last_invoke_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    if (status != kTfLiteOk) {
         std::cerr << "ocr inference failed..." << std::endl;
         return ""; // Changed from -1 to ""
     }
 
     // Decode output
     auto output_details = interpreter->tensor(interpreter->outputs()[0]);
-    const float* output_data = output_details->data.f;
     int time = output_details->dims->data[1];
     int classes = output_details->dims->data[2];
+    const float* output_data = read_ocr_output(output_details, 0, static_cast<size_t>(time) * classes, dequantized_output);
 
-    std::vector<int> indices = ctcGreedyDecoder(output_data, time, classes);
+    ctc_greedy_decode(output_data, time, classes, ctc_result);
 
     // Convert indices to characters
     std::string result;
-    for (int idx : indices) {
+    for (int idx : ctc_result.indices) {
         if (label_map.count(idx)) {
             result += label_map[idx];
         }
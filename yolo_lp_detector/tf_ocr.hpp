@@ -11,13 +11,24 @@
 #include <vector>
 #include <string>
 
+#include "ocr_engine.hpp"
+#include "ocr_tensor.hpp"
+#include "ctc_decode.hpp"
+
 class TFOCR {
     public:
-        void load_ocr(const std::string& model_path, const std::string& labels_path);
+        void load_ocr(const std::string& model_path, const std::string& labels_path,
+                      const OcrEngineConfig& engine_config = OcrEngineConfig());
         std::string run_ocr(const cv::Mat& input_img);
+        // Duration of the most recent Invoke()
+        double lastInvokeMs() const { return last_invoke_ms; }
     private:
         std::map<int, std::string> loadLabelMap(const std::string& path);
-        std::vector<int> ctcGreedyDecoder(const float* logits, int time, int classes);
+
+        double last_invoke_ms = 0.0;
+        cv::Mat resized_input;                  // model-size grayscale buffer
+        std::vector<float> dequantized_output;  // logits of quantized models
+        CtcDecodeResult ctc_result;             // reused decode buffers
 
         std::map<int, std::string> label_map;
         std::unique_ptr<tflite::FlatBufferModel> model;
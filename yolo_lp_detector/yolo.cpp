@@ -10,232 +10,83 @@
 #include <algorithm>
 #include <iostream> // 디버깅용
 #include <chrono> // 시간 측정용
+#include <fstream>
 
+#include "postprocess.hpp"
 
 
-static inline float sigmoid(float x)
-{
-    return static_cast<float>(1.f / (1.f + exp(-x)));
-}
-
-static inline float intersection_area(const Object& a, const Object& b)
-{
-    cv::Rect_<float> inter = a.rect & b.rect;
-    return inter.area();
-}
-
-static void qsort_descent_inplace(std::vector<Object>& faceobjects, int left, int right)
-{
-    int i = left;
-    int j = right;
-    float p = faceobjects[(left + right) / 2].prob;
-
-    while (i <= j)
-    {
-        while (faceobjects[i].prob > p)
-            i++;
-
-        while (faceobjects[j].prob < p)
-            j--;
-
-        if (i <= j)
-        {
-            // swap
-            std::swap(faceobjects[i], faceobjects[j]);
-
-            i++;
-            j--;
-        }
-    }
-
-    #pragma omp parallel sections
-    {
-        #pragma omp section
-        {
-            if (left < j) qsort_descent_inplace(faceobjects, left, j);
-        }
-        #pragma omp section
-        {
-            if (i < right) qsort_descent_inplace(faceobjects, i, right);
-        }
-    }
-}
 
-static void qsort_descent_inplace(std::vector<Object>& faceobjects)
-{
-    if (faceobjects.empty())
-        return;
+// anchor setting from yolov5/models/yolov5s.yaml
+const int YOLO_STRIDES[3] = { 8, 16, 32 };
+const float YOLO_ANCHORS[3][6] = {
+    { 10.f, 13.f, 16.f, 30.f, 33.f, 23.f },
+    { 30.f, 61.f, 62.f, 45.f, 59.f, 119.f },
+    { 116.f, 90.f, 156.f, 198.f, 373.f, 326.f }
+};
 
-    qsort_descent_inplace(faceobjects, 0, faceobjects.size() - 1);
-}
+static const uint32_t YOLO_OUTPUT_MAGIC = 0x594f4c4f; // "YOLO"
 
-static void nms_sorted_bboxes(const std::vector<Object>& faceobjects, std::vector<int>& picked, float nms_threshold, bool agnostic = false)
+bool save_yolo_output(const std::string& path, const YoloOutput& output)
 {
-    picked.clear();
-
-    const int n = faceobjects.size();
-
-    std::vector<float> areas(n);
-    for (int i = 0; i < n; i++)
+    std::ofstream file(path, std::ios::binary);
+    if (!file)
+        return false;
+
+    int32_t header[4] = { output.img_w, output.img_h, output.wpad, output.hpad };
+    file.write(reinterpret_cast<const char*>(&YOLO_OUTPUT_MAGIC), sizeof(YOLO_OUTPUT_MAGIC));
+    file.write(reinterpret_cast<const char*>(header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(&output.scale), sizeof(output.scale));
+    for (const ncnn::Mat& blob : output.out)
     {
-        areas[i] = faceobjects[i].rect.area();
-    }
-
-    for (int i = 0; i < n; i++)
-    {
-        const Object& a = faceobjects[i];
-
-        int keep = 1;
-        for (int j = 0; j < (int)picked.size(); j++)
-        {
-            const Object& b = faceobjects[picked[j]];
-
-            if (!agnostic && a.label != b.label)
-                continue;
-
-            // intersection over union
-            float inter_area = intersection_area(a, b);
-            float union_area = areas[i] + areas[picked[j]] - inter_area;
-            // float IoU = inter_area / union_area
-            if (inter_area / union_area > nms_threshold)
-                keep = 0;
-        }
-
-        if (keep)
-            picked.push_back(i);
+        int32_t dims[3] = { blob.w, blob.h, blob.c };
+        file.write(reinterpret_cast<const char*>(dims), sizeof(dims));
+        for (int c = 0; c < blob.c; c++)
+            file.write(reinterpret_cast<const char*>((const float*)blob.channel(c)), sizeof(float) * blob.w * blob.h);
     }
+    return static_cast<bool>(file);
 }
 
-static void generate_proposals(const ncnn::Mat& anchors, int stride, const ncnn::Mat& in_pad, const ncnn::Mat& feat_blob, float prob_threshold, std::vector<Object>& objects)
+bool load_yolo_output(const std::string& path, YoloOutput& output)
 {
-    // the out blob would be a 3-dim tensor with w=dynamic h=dynamic c=255=85*3
-    // we view it as [grid_w,grid_h,85,3] for 3 anchor ratio types
-
-    //
-    //            |<--   dynamic anchor grids     -->|
-    //            |   larger image yields more grids |
-    //            +-------------------------- // ----+
-    //           /| center-x                         |
-    //          / | center-y                         |
-    //         /  | box-w                            |
-    // anchor-0   | box-h                            |
-    //  +-----+   | box score(1)                     |
-    //  |     |   +----------------                  |
-    //  |     |   | per-class scores(80)             |
-    //  +-----+\  |   .                              |
-    //          \ |   .                              |
-    //           \|   .                              |
-    //            +-------------------------- // ----+
-    //           /| center-x                         |
-    //          / | center-y                         |
-    //         /  | box-w                            |
-    // anchor-1   | box-h                            |
-    //  +-----+   | box score(1)                     |
-    //  |     |   +----------------                  |
-    //  +-----+   | per-class scores(80)             |
-    //         \  |   .                              |
-    //          \ |   .                              |
-    //           \|   .                              |
-    //            +-------------------------- // ----+
-    //           /| center-x                         |
-    //          / | center-y                         |
-    //         /  | box-w                            |
-    // anchor-2   | box-h                            |
-    //  +--+      | box score(1)                     |
-    //  |  |      +----------------                  |
-    //  |  |      | per-class scores(80)             |
-    //  +--+   \  |   .                              |
-    //          \ |   .                              |
-    //           \|   .                              |
-    //            +-------------------------- // ----+
-    //
-
-    const int num_grid_x = feat_blob.w;
-    const int num_grid_y = feat_blob.h;
-
-    const int num_anchors = anchors.w / 2;
-
-    const int num_class = feat_blob.c / num_anchors - 5;
-
-    const int feat_offset = num_class + 5;
-
-    // enumerate all anchor types
-    for (int q = 0; q < num_anchors; q++)
+    std::ifstream file(path, std::ios::binary);
+    uint32_t magic = 0;
+    int32_t header[4];
+    if (!file.read(reinterpret_cast<char*>(&magic), sizeof(magic)) || magic != YOLO_OUTPUT_MAGIC ||
+        !file.read(reinterpret_cast<char*>(header), sizeof(header)) ||
+        !file.read(reinterpret_cast<char*>(&output.scale), sizeof(output.scale)))
+        return false;
+
+    output.img_w = header[0];
+    output.img_h = header[1];
+    output.wpad = header[2];
+    output.hpad = header[3];
+    for (ncnn::Mat& blob : output.out)
     {
-        const float anchor_w = anchors[q * 2];
-        const float anchor_h = anchors[q * 2 + 1];
-
-        for (int i = 0; i < num_grid_y; i++)
+        int32_t dims[3];
+        if (!file.read(reinterpret_cast<char*>(dims), sizeof(dims)) || dims[0] <= 0 || dims[1] <= 0 || dims[2] <= 0)
+            return false;
+        blob.create(dims[0], dims[1], dims[2]);
+        for (int c = 0; c < blob.c; c++)
         {
-            for (int j = 0; j < num_grid_x; j++)
-            {
-                // find class index with max class score
-                int class_index = 0;
-                float class_score = -FLT_MAX;
-                for (int k = 0; k < num_class; k++)
-                {
-                    float score = feat_blob.channel(q * feat_offset + 5 + k).row(i)[j];
-                    if (score > class_score)
-                    {
-                        class_index = k;
-                        class_score = score;
-                    }
-                }
-
-                float box_score = feat_blob.channel(q * feat_offset + 4).row(i)[j];
-
-                // combined score = box score * class score
-                // apply sigmoid first to get normed 0~1 value
-                float confidence = sigmoid(box_score) * sigmoid(class_score);
-
-                // filter candidate boxes with combined score >= prob_threshold
-                if (confidence < prob_threshold)
-                    continue;
-
-                // yolov5/models/yolo.py Detect forward
-                // y = x[i].sigmoid()
-                // y[..., 0:2] = (y[..., 0:2] * 2. - 0.5 + self.grid[i].to(x[i].device)) * self.stride[i]  # xy
-                // y[..., 2:4] = (y[..., 2:4] * 2) ** 2 * self.anchor_grid[i]  # wh
-
-                float dx = sigmoid(feat_blob.channel(q * feat_offset + 0).row(i)[j]);
-                float dy = sigmoid(feat_blob.channel(q * feat_offset + 1).row(i)[j]);
-                float dw = sigmoid(feat_blob.channel(q * feat_offset + 2).row(i)[j]);
-                float dh = sigmoid(feat_blob.channel(q * feat_offset + 3).row(i)[j]);
-
-                float cx = (dx * 2.f - 0.5f + j) * stride;
-                float cy = (dy * 2.f - 0.5f + i) * stride;
-
-                float bw = pow(dw * 2.f, 2) * anchor_w;
-                float bh = pow(dh * 2.f, 2) * anchor_h;
-
-                // transform candidate box (center-x,center-y,w,h) to (x0,y0,x1,y1)
-                float x0 = cx - bw * 0.5f;
-                float y0 = cy - bh * 0.5f;
-                float x1 = cx + bw * 0.5f;
-                float y1 = cy + bh * 0.5f;
-
-                // collect candidates
-                Object obj;
-                obj.rect.x = x0;
-                obj.rect.y = y0;
-                obj.rect.width = x1 - x0;
-                obj.rect.height = y1 - y0;
-                obj.label = class_index;
-                obj.prob = confidence;
-
-                objects.push_back(obj);
-            }
+            if (!file.read(reinterpret_cast<char*>((float*)blob.channel(c)), sizeof(float) * blob.w * blob.h))
+                return false;
         }
     }
+    return true;
 }
 
-Yolo::Yolo() {
+Yolo::Yolo() : postprocess_(new YoloPostprocess()) {
 }
 Yolo::~Yolo() {
 }
 
-void Yolo::load(const std::string& param_path, const std::string& model_path) {
+void Yolo::load(const std::string& param_path, const std::string& model_path, const YoloEngineConfig& config) {
     std::cout << "[DEBUG] :: Yolo::load() param: " << param_path << ", model: " << model_path << std::endl;
+    std::cout << "[DEBUG] :: Yolo::load() options: " << describe_yolo_engine_config(config) << std::endl;
+    yolov5.clear();
+    blob_pool.clear();
+    workspace_pool.clear();
+    apply_yolo_engine_config(config, yolov5.opt, &blob_pool, &workspace_pool);
     yolov5.load_param(param_path.c_str());
     yolov5.load_model(model_path.c_str());
     std::cout << "[DEBUG] :: Yolo::load() completed" << std::endl;
@@ -243,6 +94,15 @@ void Yolo::load(const std::string& param_path, const std::string& model_path) {
 
 
 int Yolo::detect(cv::Mat bgr, std::vector<Object>& objects, int target_size, float prob_threshold, float nms_threshold){
+    YoloOutput output;
+    int ret = forward(bgr, target_size, output);
+    if (ret != 0)
+        return ret;
+    postprocess(output, prob_threshold, nms_threshold, objects);
+    return 0;
+}
+
+int Yolo::forward(const cv::Mat& bgr, int target_size, YoloOutput& output){
     // std::cout << "[DEBUG] Yolo::detect()" << std::endl;
     // std::cout << "[DEBUG] Input Image Size: " << bgr.cols << "x" << bgr.rows << std::endl;
 
@@ -288,100 +148,22 @@ int Yolo::detect(cv::Mat bgr, std::vector<Object>& objects, int target_size, flo
 
     ex.input("in0", in_pad);
 
-    ncnn::Mat out0;
-    ncnn::Mat out1;
-    ncnn::Mat out2;
-    ex.extract("194", out0);
-    ex.extract("210", out1);
-    ex.extract("226", out2);
-
-
-    std::vector<Object> proposals;
-
-    // anchor setting from yolov5/models/yolov5s.yaml
-
-    // stride 8
-    {
-        ncnn::Mat anchors(6);
-        anchors[0] = 10.f;
-        anchors[1] = 13.f;
-        anchors[2] = 16.f;
-        anchors[3] = 30.f;
-        anchors[4] = 33.f;
-        anchors[5] = 23.f;
-
-        std::vector<Object> objects8;
-        generate_proposals(anchors, 8, in_pad, out0, prob_threshold, objects8);
-
-        proposals.insert(proposals.end(), objects8.begin(), objects8.end());
-    }
-
-    // stride 16
-    {
-        ncnn::Mat anchors(6);
-        anchors[0] = 30.f;
-        anchors[1] = 61.f;
-        anchors[2] = 62.f;
-        anchors[3] = 45.f;
-        anchors[4] = 59.f;
-        anchors[5] = 119.f;
-
-        std::vector<Object> objects16;
-        generate_proposals(anchors, 16, in_pad, out1, prob_threshold, objects16);
-
-        proposals.insert(proposals.end(), objects16.begin(), objects16.end());
-    }
-
-    // stride 32
-    {
-        ncnn::Mat anchors(6);
-        anchors[0] = 116.f;
-        anchors[1] = 90.f;
-        anchors[2] = 156.f;
-        anchors[3] = 198.f;
-        anchors[4] = 373.f;
-        anchors[5] = 326.f;
-
-        std::vector<Object> objects32;
-        generate_proposals(anchors, 32, in_pad, out2, prob_threshold, objects32);
-
-        proposals.insert(proposals.end(), objects32.begin(), objects32.end());
-    }
-
-    // sort all candidates by score from highest to lowest
-    qsort_descent_inplace(proposals);
-
-    // apply non max suppression
-    std::vector<int> picked;
-    nms_sorted_bboxes(proposals, picked, nms_threshold);
+    ex.extract("194", output.out[0]);
+    ex.extract("210", output.out[1]);
+    ex.extract("226", output.out[2]);
 
-    // collect final result after nms
-    const int count = picked.size();
-    objects.resize(count);
-    for (int i = 0; i < count; i++)
-    {
-        objects[i] = proposals[picked[i]];
-
-        // adjust offset to original unpadded
-        float x0 = (objects[i].rect.x - (wpad / 2)) / scale;
-        float y0 = (objects[i].rect.y - (hpad / 2)) / scale;
-        float x1 = (objects[i].rect.x + objects[i].rect.width - (wpad / 2)) / scale;
-        float y1 = (objects[i].rect.y + objects[i].rect.height - (hpad / 2)) / scale;
-
-        // clip
-        x0 = std::max(std::min(x0, (float)(img_w - 1)), 0.f);
-        y0 = std::max(std::min(y0, (float)(img_h - 1)), 0.f);
-        x1 = std::max(std::min(x1, (float)(img_w - 1)), 0.f);
-        y1 = std::max(std::min(y1, (float)(img_h - 1)), 0.f);
-
-        objects[i].rect.x = x0;
-        objects[i].rect.y = y0;
-        objects[i].rect.width = x1 - x0;
-        objects[i].rect.height = y1 - y0;
-    }
+    output.img_w = img_w;
+    output.img_h = img_h;
+    output.scale = scale;
+    output.wpad = wpad;
+    output.hpad = hpad;
     return 0;
 }
 
+void Yolo::postprocess(const YoloOutput& output, float prob_threshold, float nms_threshold, std::vector<Object>& objects){
+    postprocess_->run(output, prob_threshold, nms_threshold, objects);
+}
+
 cv::Mat Yolo::draw_result(const cv::Mat& bgr, const std::vector<Object>& objects)
 {
     static const char* class_names[] = {
@@ -433,23 +215,37 @@ std::vector<cv::Mat> Yolo::crop_objects(const cv::Mat& bgr, const std::vector<Ob
         if (w > 0 && h > 0) {
             cv::Rect roi(x, y, w, h);
             crops.push_back(bgr(roi).clone());
+        } else {
+            crops.push_back(cv::Mat());    // keep crops[i] aligned with objects[i]
         }
     }
     return crops;
 }
 
 void Yolo::calc_distance(std::vector<Object>& objects, const cv::Point2f& point, cv::Mat& image) {
+    sort_by_distance(objects, point);
+    draw_distance(objects, point, image);
+}
+
+void Yolo::sort_by_distance(std::vector<Object>& objects, const cv::Point2f& point) {
     for (auto& obj : objects) {
         float center_x = obj.rect.x + obj.rect.width / 2;
         float center_y = obj.rect.y + obj.rect.height / 2;
         float distance = std::sqrt(std::pow(center_x - point.x, 2) + std::pow(center_y - point.y, 2));
         obj.prob = distance; // prob 필드에 거리 저장
+    }
+    std::sort(objects.begin(), objects.end(), [](const Object& a, const Object& b) {
+        return a.prob < b.prob;
+    });
+}
+
+void Yolo::draw_distance(const std::vector<Object>& objects, const cv::Point2f& point, cv::Mat& image) {
+    for (const auto& obj : objects) {
+        float center_x = obj.rect.x + obj.rect.width / 2;
+        float center_y = obj.rect.y + obj.rect.height / 2;
 
         cv::circle(image, point, 3, cv::Scalar(0, 255, 0), -1);            // 이미지에 포인트 표시
         // Draw line between point and object center
         cv::line(image, point, cv::Point2f(center_x, center_y), cv::Scalar(0, 255, 0), 2);
     }
-    std::sort(objects.begin(), objects.end(), [](const Object& a, const Object& b) {
-        return a.prob < b.prob;
-    });
 }
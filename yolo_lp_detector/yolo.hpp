@@ -4,6 +4,12 @@
 
 #include <opencv2/core/core.hpp>
 #include <ncnn/net.h>
+#include <ncnn/allocator.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "yolo_engine.hpp"
 
 struct Object
 {
@@ -13,18 +19,57 @@ struct Object
     std::string ocr_result = "AA99A9999";
 };
 
+// Head strides and their three (w, h) anchors each
+extern const int YOLO_STRIDES[3];
+extern const float YOLO_ANCHORS[3][6];
+
+// Raw head outputs of one frame and the letterbox that produced them
+struct YoloOutput
+{
+    ncnn::Mat out[3];           // strides 8, 16, 32
+    int img_w = 0;
+    int img_h = 0;
+    float scale = 1.f;          // input -> letterboxed
+    int wpad = 0;
+    int hpad = 0;
+};
+
+// Captured outputs for offline benchmarks (--bench capture)
+bool save_yolo_output(const std::string& path, const YoloOutput& output);
+bool load_yolo_output(const std::string& path, YoloOutput& output);
+
+class YoloPostprocess;
+
 class Yolo
 {
 public:
     Yolo();
     ~Yolo();
-    void load(const std::string& param_path, const std::string& model_path);
+    // Options are applied before the model is read, so calling load() again
+    // with another config rebuilds the network
+    void load(const std::string& param_path, const std::string& model_path,
+              const YoloEngineConfig& config = YoloEngineConfig());
     int detect(cv::Mat bgr, std::vector<Object>& objects, int target_size, float prob_threshold, float nms_threshold);
+    // detect() in two steps: network inference, then box decoding + NMS
+    int forward(const cv::Mat& bgr, int target_size, YoloOutput& output);
+    void postprocess(const YoloOutput& output, float prob_threshold, float nms_threshold, std::vector<Object>& objects);
     cv::Mat draw_result(const cv::Mat& bgr, const std::vector<Object>& objects);
+    // sort_by_distance() + draw_distance()
     void calc_distance(std::vector<Object>& objects, const cv::Point2f& point, cv::Mat& image);
+    // Stores each object's distance from `point` in prob and sorts nearest first
+    void sort_by_distance(std::vector<Object>& objects, const cv::Point2f& point);
+    // Lines from `point` to every object center
+    void draw_distance(const std::vector<Object>& objects, const cv::Point2f& point, cv::Mat& image);
+    // One crop per object (crops[i] for objects[i]), empty if its box lies outside the frame
     std::vector<cv::Mat> crop_objects(const cv::Mat& bgr, const std::vector<Object>& objects);
 private:
+    // Reused across frames when config.pool_allocators is set; the blob
+    // pool is only touched by the thread running forward(). Declared before
+    // the net so they outlive it.
+    ncnn::UnlockedPoolAllocator blob_pool;
+    ncnn::PoolAllocator workspace_pool;
     ncnn::Net yolov5;
+    std::unique_ptr<YoloPostprocess> postprocess_;
 };
 
 #endif // YOLO_HPP
\ No newline at end of file
@@ -0,0 +1,59 @@
+#include "yolo_engine.hpp"
+
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#include "json.hpp"
+
+bool load_yolo_engine_config(const std::string& path, YoloEngineConfig& config) {
+    std::ifstream file(path);
+    if (!file) {
+        return false;
+    }
+
+    YoloEngineConfig loaded = config;
+    try {
+        nlohmann::json j = nlohmann::json::parse(file);
+        loaded.num_threads = j.value("num_threads", loaded.num_threads);
+        loaded.use_fp16_storage = j.value("use_fp16_storage", loaded.use_fp16_storage);
+        loaded.use_fp16_arithmetic = j.value("use_fp16_arithmetic", loaded.use_fp16_arithmetic);
+        loaded.use_packing_layout = j.value("use_packing_layout", loaded.use_packing_layout);
+        loaded.lightmode = j.value("lightmode", loaded.lightmode);
+        loaded.use_winograd_convolution = j.value("use_winograd_convolution", loaded.use_winograd_convolution);
+        loaded.pool_allocators = j.value("pool_allocators", loaded.pool_allocators);
+    } catch (const nlohmann::json::exception& e) {
+        std::cerr << "[YOLO] Failed to parse " << path << ": " << e.what() << std::endl;
+        return false;
+    }
+
+    config = loaded;
+    return true;
+}
+
+std::string describe_yolo_engine_config(const YoloEngineConfig& config) {
+    std::ostringstream out;
+    out << "threads=" << config.num_threads
+        << " fp16_storage=" << (config.use_fp16_storage ? "on" : "off")
+        << " fp16_arithmetic=" << (config.use_fp16_arithmetic ? "on" : "off")
+        << " packing=" << (config.use_packing_layout ? "on" : "off")
+        << " lightmode=" << (config.lightmode ? "on" : "off")
+        << " winograd=" << (config.use_winograd_convolution ? "on" : "off")
+        << " pools=" << (config.pool_allocators ? "on" : "off");
+    return out.str();
+}
+
+void apply_yolo_engine_config(const YoloEngineConfig& config, ncnn::Option& opt,
+                              ncnn::Allocator* blob_allocator, ncnn::Allocator* workspace_allocator) {
+    if (config.num_threads > 0) {
+        opt.num_threads = config.num_threads;
+    }
+    opt.use_fp16_packed = config.use_fp16_storage;
+    opt.use_fp16_storage = config.use_fp16_storage;
+    opt.use_fp16_arithmetic = config.use_fp16_arithmetic;
+    opt.use_packing_layout = config.use_packing_layout;
+    opt.lightmode = config.lightmode;
+    opt.use_winograd_convolution = config.use_winograd_convolution;
+    opt.blob_allocator = config.pool_allocators ? blob_allocator : nullptr;
+    opt.workspace_allocator = config.pool_allocators ? workspace_allocator : nullptr;
+}
@@ -0,0 +1,44 @@
+#ifndef YOLO_ENGINE_HPP
+#define YOLO_ENGINE_HPP
+
+#include <string>
+
+#include <ncnn/net.h>
+
+// ncnn runtime settings of the plate detector. Loaded from a JSON file
+// such as:
+//
+//   {
+//     "num_threads": 4,
+//     "use_fp16_storage": true,
+//     "use_fp16_arithmetic": true,
+//     "use_packing_layout": true,
+//     "lightmode": true,
+//     "use_winograd_convolution": true,
+//     "pool_allocators": true
+//   }
+//
+// Missing keys keep their defaults. Those are ncnn's own, except
+// pool_allocators: ncnn has no blob/workspace allocator by default.
+struct YoloEngineConfig {
+    int num_threads = -1;                   // -1: ncnn default (big cores)
+    bool use_fp16_storage = true;           // fp16 weights/blobs (also fp16 packed)
+    bool use_fp16_arithmetic = true;
+    bool use_packing_layout = true;         // elempack 4/8 for NEON
+    bool lightmode = true;                  // free intermediate blobs early
+    bool use_winograd_convolution = true;
+    bool pool_allocators = true;            // keep blob/workspace memory between frames
+};
+
+// Returns false (and keeps `config` untouched) if the file cannot be read
+// or parsed
+bool load_yolo_engine_config(const std::string& path, YoloEngineConfig& config);
+
+std::string describe_yolo_engine_config(const YoloEngineConfig& config);
+
+// Apply `config` to `opt`; the allocators are only used when
+// config.pool_allocators is set. Must happen before the model is loaded.
+void apply_yolo_engine_config(const YoloEngineConfig& config, ncnn::Option& opt,
+                              ncnn::Allocator* blob_allocator, ncnn::Allocator* workspace_allocator);
+
+#endif // YOLO_ENGINE_HPP